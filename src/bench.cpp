@@ -0,0 +1,379 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "evaluator.h"
+#include "grid.h"
+#include "interval_file.h"
+#include "point_evaluator.h"
+#include "reader.h"
+#include "synthetic.h"
+#include "thread_pool.h"
+
+using namespace std;
+using namespace anomaly;
+
+struct bench_result
+{
+  string name;
+  double seconds;  // Best of all repeats
+  double items;    // Labels or ranges processed per run
+  double baseline; // Seconds in the baseline file, or < 0 if none
+};
+
+//----------------------------------------------------------------------------
+// Best wall clock time of several runs of f.
+//----------------------------------------------------------------------------
+template <typename Function>
+double time_best(int repeats, Function f)
+{
+  double best = 0;
+  for (int i = 0; i < repeats; ++i)
+  {
+    auto start = chrono::steady_clock::now();
+    f();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - 
+                                              start).count();
+    if ((i == 0) || (seconds < best)) best = seconds;
+  }
+  return best;
+}
+
+//----------------------------------------------------------------------------
+// Reads the seconds of every result of a file written by this program, and
+// the line describing its workload.
+//----------------------------------------------------------------------------
+map<string, double> read_baseline(string const &path, string &workload_line)
+{
+  ifstream file(path.c_str());
+  if (!file.is_open()) throw "Error: Could not open file!";
+
+  map<string, double> seconds;
+  string line;
+  while (getline(file, line))
+  {
+    if (line.find("\"workload\": ") != string::npos) workload_line = line;
+
+    size_t name = line.find("\"name\": \"");
+    size_t time = line.find("\"seconds\": ");
+    if ((name == string::npos) || (time == string::npos)) continue;
+
+    name += 9;
+    seconds[line.substr(name, line.find('"', name) - name)] = 
+      atof(line.c_str() + time + 11);
+  }
+  return seconds;
+}
+
+//----------------------------------------------------------------------------
+// Pairs of (.real, .pred) files in the subdirectories of the examples.
+//----------------------------------------------------------------------------
+vector<pair<string, string> > find_examples(string const &root)
+{
+  vector<pair<string, string> > examples;
+  DIR *dir = opendir(root.c_str());
+  if (dir == NULL) return examples;
+
+  vector<string> datasets;
+  for (dirent *entry; (entry = readdir(dir)) != NULL; )
+  {
+    if (entry->d_name[0] != '.') datasets.push_back(entry->d_name);
+  }
+  closedir(dir);
+  sort(datasets.begin(), datasets.end());
+
+  for (auto d = datasets.begin(); d != datasets.end(); ++d)
+  {
+    string path = root + "/" + *d;
+    if ((dir = opendir(path.c_str())) == NULL) continue;
+
+    vector<string> files;
+    for (dirent *entry; (entry = readdir(dir)) != NULL; )
+    {
+      string file = entry->d_name;
+      if ((file.size() > 5) && (file.compare(file.size() - 5, 5, ".real") == 0))
+        files.push_back(file.substr(0, file.size() - 5));
+    }
+    closedir(dir);
+    sort(files.begin(), files.end());
+
+    for (auto f = files.begin(); f != files.end(); ++f)
+    {
+      string base = path + "/" + *f;
+      if (ifstream((base + ".pred").c_str()).good())
+        examples.push_back(make_pair(*d + "/" + *f, base));
+    }
+  }
+  return examples;
+}
+
+//----------------------------------------------------------------------------
+void output_usage(char *argv[])
+{
+  cout << endl;
+  cout << "Usage: " << endl;
+  cout << argv[0] 
+       << " {-n <length>} {-d <density>} {-l <mean_length>} {-r <repeats>}"
+       << " {-w <work_dir>} {-e <examples_dir>} {-x <evaluate>}"
+       << " {-b <baseline.json>} {-t <tolerance>}"
+       << endl;
+  cout << "    -n, -d, -l: " 
+       << "Synthetic workload, as for tsad_gen." 
+       << endl;
+  cout << "    -r        : " 
+       << "Runs per benchmark, the best one counts, Default = 5" 
+       << endl;
+  cout << "    -w        : " 
+       << "Directory for the generated data files, Default = ." 
+       << endl;
+  cout << "    -e        : " 
+       << "Datasets for end-to-end runs, Default = ../examples" 
+       << endl;
+  cout << "    -x        : " 
+       << "Evaluator binary for end-to-end runs, Default = ./evaluate" 
+       << endl;
+  cout << "    -b        : " 
+       << "Compare against the results of an earlier run." 
+       << endl;
+  cout << "    -t        : " 
+       << "Slowdown that counts as a regression, Default = 0.1 (10%)" 
+       << endl;
+  cout << endl;
+}
+
+//----------------------------------------------------------------------------
+// Runs all benchmarks and writes their results as JSON to stdout, and a
+// comparison with the baseline (if any) to stderr. Returns 1 if any
+// benchmark regressed.
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  workload w;
+  w.length = 20000000;
+  w.density = 0.1;
+  w.mean_range_length = 20;
+
+  int repeats = 5;
+  string work_dir = ".", examples_dir = "../examples", evaluate = "./evaluate";
+  string baseline_file;
+  double tolerance = 0.1;
+
+  for (int i = 1; i < argc; i += 2)
+  {
+    string option = argv[i];
+    if (i + 1 >= argc)
+    {
+      output_usage(argv);
+      return 1;
+    }
+    char const *value = argv[i + 1];
+
+    if (option == "-n") w.length = atoll(value);
+    else if (option == "-d") w.density = atof(value);
+    else if (option == "-l") w.mean_range_length = atof(value);
+    else if (option == "-r") repeats = max(1, atoi(value));
+    else if (option == "-w") work_dir = value;
+    else if (option == "-e") examples_dir = value;
+    else if (option == "-x") evaluate = value;
+    else if (option == "-b") baseline_file = value;
+    else if (option == "-t") tolerance = atof(value);
+    else
+    {
+      output_usage(argv);
+      return 1;
+    }
+  }
+
+  vector<bench_result> results;
+  time_intervals real, predicted;
+  string real_file = work_dir + "/bench.real";
+  string predicted_file = work_dir + "/bench.pred";
+  string interval_file = work_dir + "/bench.tsai";
+
+  auto add = [&](string const &name, double items, double seconds)
+  {
+    bench_result r = {name, seconds, items, -1};
+    results.push_back(r);
+    cerr << name << ": " << seconds << " s" << endl;
+  };
+
+  try
+  {
+    generate_workload(w, real, predicted);
+    write_label_file(real_file, real, w.length);
+    write_label_file(predicted_file, predicted, w.length);
+    write_interval_file(interval_file, real, w.length, true);
+
+    // Parsing
+    timestamp count = 0;
+    add("parse/read_file", w.length, time_best(repeats, [&]
+      { read_file(real_file, count); }));
+    add("parse/read_file_unitsize", w.length, time_best(repeats, [&]
+      { read_file_unitsize(real_file, count); }));
+    add("parse/interval_file", w.length, time_best(repeats, [&]
+      { read_file(interval_file, count); }));
+
+    // Time series metrics for each gamma and delta (on both metrics)
+    overlap_cardinality gammas[] = {e_one, e_reciprocal, e_udf_gamma};
+    positional_bias deltas[] = {e_flat, e_front, e_middle, e_back, 
+                                e_udf_delta};
+    double ranges = real.size() + predicted.size();
+    for (auto g = begin(gammas); g != end(gammas); ++g)
+    for (auto d = begin(deltas); d != end(deltas); ++d)
+    {
+      evaluator e(real, predicted, 1, 0, *g, *d, *d);
+      add(string("metrics/") + cardinality_name(*g) + "/" + bias_name(*d),
+          ranges, time_best(repeats, [&]
+          { e.compute_precision(); e.compute_recall(); }));
+    }
+
+    unsigned threads = thread_pool::hardware_threads();
+    if (threads > 1)
+    {
+      evaluator e(real, predicted, 1, 0, e_reciprocal, e_front, e_front);
+      e.set_threads(threads);
+      add("metrics/threads", ranges, time_best(repeats, [&]
+        { e.compute_precision(); e.compute_recall(); }));
+    }
+
+    evaluator reference(real, predicted, 1, 0, e_reciprocal, e_front, e_front);
+    parameter_grid grid;
+    grid.betas.push_back(1);
+    grid.alpha_rs.push_back(0);
+    grid.gammas.assign(begin(gammas), end(gammas));
+    grid.delta_ps.assign(begin(deltas), end(deltas));
+    grid.delta_rs.assign(begin(deltas), end(deltas));
+    add("metrics/grid", ranges, time_best(repeats, [&]
+      { evaluate_grid(reference, grid); }));
+
+    // Point metrics
+    for (int classical = 1; classical >= 0; --classical)
+    {
+      point_evaluator e(real, predicted, w.length, classical != 0, 1, 0,
+                        e_reciprocal, e_front, e_front);
+      add(classical ? "points/classical" : "points/numenta", w.length,
+          time_best(repeats, [&] 
+          { e.compute_precision(); e.compute_recall(); }));
+    }
+
+    // End-to-end runs of the command line tool
+    vector<pair<string, string> > examples = find_examples(examples_dir);
+    for (auto x = examples.begin(); x != examples.end(); ++x)
+    {
+      string command = evaluate + " -t " + x->second + ".real " + x->second + 
+                       ".pred 1 0 reciprocal flat front > /dev/null";
+      bool failed = false;
+      double seconds = time_best(repeats, [&]
+        { failed = failed || (system(command.c_str()) != 0); });
+      if (failed) throw "Error: End-to-end run failed!";
+      add("cli/" + x->first, 1, seconds);
+    }
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
+
+  remove(real_file.c_str());
+  remove(predicted_file.c_str());
+  remove(interval_file.c_str());
+
+  ostringstream workload_line;
+  workload_line << "  \"workload\": {\"length\": " << w.length 
+                << ", \"density\": " << w.density
+                << ", \"mean_range_length\": " << w.mean_range_length
+                << ", \"real_ranges\": " << real.size()
+                << ", \"predicted_ranges\": " << predicted.size() << "},";
+
+  // Comparison with the baseline
+  int regressions = 0;
+  if (!baseline_file.empty())
+  {
+    map<string, double> baseline;
+    string baseline_workload;
+    try
+    {
+      baseline = read_baseline(baseline_file, baseline_workload);
+    }
+    catch (const char* msg)
+    {
+      cerr << msg << endl;
+      return 1;
+    }
+
+    cerr << endl << "Compared to " << baseline_file << ":" << endl;
+    if (baseline_workload != workload_line.str())
+      cerr << "Warning: The baseline was run on a different workload!" << endl;
+    for (auto r = results.begin(); r != results.end(); ++r)
+    {
+      auto b = baseline.find(r->name);
+      if ((b == baseline.end()) || (b->second <= 0)) continue;
+
+      r->baseline = b->second;
+      double change = r->seconds / r->baseline - 1;
+      bool regressed = change > tolerance;
+      regressions += regressed;
+
+      char line[256];
+      snprintf(line, sizeof(line), "%-40s %10.6f s %10.6f s %+7.1f%%%s",
+               r->name.c_str(), r->baseline, r->seconds, 100 * change,
+               regressed ? "  REGRESSION" : "");
+      cerr << line << endl;
+    }
+  }
+
+  cout.precision(9);
+  cout << "{" << endl;
+  cout << workload_line.str() << endl;
+  cout << "  \"repeats\": " << repeats << "," << endl;
+  cout << "  \"results\": [" << endl;
+  for (auto r = results.begin(); r != results.end(); ++r)
+  {
+    cout << "    {\"name\": \"" << r->name << "\", \"seconds\": " << r->seconds
+         << ", \"items\": " << r->items
+         << ", \"items_per_second\": " << r->items / r->seconds;
+    if (r->baseline > 0)
+      cout << ", \"baseline_seconds\": " << r->baseline
+           << ", \"change\": " << r->seconds / r->baseline - 1;
+    cout << "}" << ((r + 1 != results.end()) ? "," : "") << endl;
+  }
+  cout << "  ]" << endl;
+  cout << "}" << endl;
+
+  return (regressions > 0) ? 1 : 0;
+}
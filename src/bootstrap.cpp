@@ -0,0 +1,243 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "bootstrap.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace anomaly;
+
+//-----------------------------------------------------------------------------
+// Sums of the rewards of a metric, and their number, in every unit that is
+// resampled: single ranges, or blocks of time.
+//-----------------------------------------------------------------------------
+struct resample_units
+{
+  std::vector<double> sums;
+  std::vector<double> counts;
+};
+
+//-----------------------------------------------------------------------------
+static void make_units(evaluator const &e, e_metric m, timestamp count,
+  timestamp block_length, resample_units &units)
+{
+  overlap_table table;
+  std::vector<range_terms> terms;
+  std::vector<double> rewards;
+  e.compute_overlaps(m, table);
+  e.compute_terms(m, table, terms);
+  e.compute_rewards(m, terms, rewards);
+
+  if (block_length <= 0)
+  {
+    units.sums.swap(rewards);
+    units.counts.assign(units.sums.size(), 1);
+    return;
+  }
+
+  interval_span ranges = (m == e_precision) ? e.get_predicted_anomalies()
+                                            : e.get_real_anomalies();
+  size_t blocks = ((size_t)count + block_length - 1) / block_length;
+  units.sums.assign(std::max<size_t>(blocks, 1), 0);
+  units.counts.assign(units.sums.size(), 0);
+  for (size_t i = 0; i < ranges.size(); ++i)
+  {
+    size_t b = std::min<size_t>(
+      std::max<timestamp>(ranges[i].first, 0) / block_length,
+      units.sums.size() - 1);
+    units.sums[b] += rewards[i];
+    units.counts[b] += 1;
+  }
+}
+
+//-----------------------------------------------------------------------------
+static double mean_of(resample_units const &units)
+{
+  double sum = 0, count = 0;
+  for (size_t i = 0; i < units.sums.size(); ++i)
+  {
+    sum += units.sums[i];
+    count += units.counts[i];
+  }
+  return (count > 0) ? sum / count : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+// Metric of a resample of units, drawn with replacement.
+//-----------------------------------------------------------------------------
+static double resample(resample_units const &units, std::mt19937_64 &random)
+{
+  size_t n = units.sums.size();
+  if (n == 0) return 0.0;
+
+  std::uniform_int_distribution<size_t> pick(0, n - 1);
+  double sum = 0, count = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    size_t u = pick(random);
+    sum += units.sums[u];
+    count += units.counts[u];
+  }
+  return (count > 0) ? sum / count : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+// Precision and recall of a resample of blocks of time: the same blocks,
+// drawn with replacement, for both metrics, which have as many blocks.
+//-----------------------------------------------------------------------------
+static void resample_blocks(resample_units const &precision_units,
+  resample_units const &recall_units, std::mt19937_64 &random,
+  double &precision, double &recall)
+{
+  size_t n = precision_units.sums.size();
+  std::uniform_int_distribution<size_t> pick(0, n - 1);
+  double precision_sum = 0, precision_count = 0;
+  double recall_sum = 0, recall_count = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    size_t b = pick(random);
+    precision_sum += precision_units.sums[b];
+    precision_count += precision_units.counts[b];
+    recall_sum += recall_units.sums[b];
+    recall_count += recall_units.counts[b];
+  }
+  precision = (precision_count > 0) ? precision_sum / precision_count : 0.0;
+  recall = (recall_count > 0) ? recall_sum / recall_count : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+static double fscore_of(evaluator const &e, double precision, double recall)
+{
+  if (precision + recall <= 0) return 0.0;
+  return e.compute_fscore(precision, recall);
+}
+
+//-----------------------------------------------------------------------------
+// Percentile interval of the values (sorted in place), interpolating
+// between neighbouring order statistics.
+//-----------------------------------------------------------------------------
+static confidence_interval interval_of(double estimate,
+  std::vector<double> &values, double confidence)
+{
+  confidence_interval interval;
+  interval.estimate = interval.lower = interval.upper = estimate;
+  if (values.empty()) return interval;
+
+  std::sort(values.begin(), values.end());
+  auto quantile = [&values](double q)
+  {
+    double position = q * (values.size() - 1);
+    size_t i = (size_t)position;
+    if (i + 1 >= values.size()) return values.back();
+    return values[i] + (position - i) * (values[i + 1] - values[i]);
+  };
+
+  interval.lower = quantile((1 - confidence) / 2);
+  interval.upper = quantile((1 + confidence) / 2);
+  return interval;
+}
+
+//-----------------------------------------------------------------------------
+bootstrap_result anomaly::bootstrap(evaluator const &e, timestamp count,
+  bootstrap_options const &options)
+{
+  if (options.resamples < 1) throw "Error: Invalid number of resamples!";
+  if (options.block_length < 0) throw "Error: Invalid block length!";
+  if (!(options.confidence > 0) || !(options.confidence < 1))
+    throw "Error: Invalid confidence level!";
+
+  resample_units precision_units, recall_units;
+  make_units(e, e_precision, count, options.block_length, precision_units);
+  make_units(e, e_recall, count, options.block_length, recall_units);
+
+  std::vector<double> precisions(options.resamples);
+  std::vector<double> recalls(options.resamples);
+  std::vector<double> fscores(options.resamples);
+
+  // Resamples are split into batches, one task each; every resample has a
+  // generator of its own, so results do not depend on the batching.
+  size_t const batch = 64;
+  thread_pool pool(options.threads);
+  for (size_t begin = 0; begin < options.resamples; begin += batch)
+  {
+    pool.submit([&, begin]
+    {
+      size_t end = std::min<size_t>(begin + batch, options.resamples);
+      for (size_t i = begin; i < end; ++i)
+      {
+        std::seed_seq seed{(unsigned)(options.seed >> 32),
+                           (unsigned)options.seed, (unsigned)(i >> 32),
+                           (unsigned)i};
+        std::mt19937_64 random(seed);
+
+        if (options.block_length > 0)
+        {
+          resample_blocks(precision_units, recall_units, random, 
+                          precisions[i], recalls[i]);
+        }
+        else
+        {
+          precisions[i] = resample(precision_units, random);
+          recalls[i] = resample(recall_units, random);
+        }
+        fscores[i] = fscore_of(e, precisions[i], recalls[i]);
+      }
+    });
+  }
+  pool.wait();
+
+  double precision = mean_of(precision_units);
+  double recall = mean_of(recall_units);
+
+  bootstrap_result result;
+  result.precision = interval_of(precision, precisions, options.confidence);
+  result.recall = interval_of(recall, recalls, options.confidence);
+  result.fscore = interval_of(fscore_of(e, precision, recall), fscores,
+                              options.confidence);
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+void anomaly::write_bootstrap(std::ostream &out, 
+  bootstrap_result const &result, bootstrap_options const &options)
+{
+  confidence_interval const *intervals[] = {&result.precision, 
+                                            &result.recall, &result.fscore};
+  char const *names[] = {"Precision", "Recall", "F-Score"};
+
+  for (int i = 0; i < 3; ++i)
+  {
+    out << names[i] << " = " << intervals[i]->estimate << ", " 
+        << options.confidence * 100 << "% CI = [" << intervals[i]->lower 
+        << ", " << intervals[i]->upper << "]" << std::endl;
+  }
+  out << "Bootstrap: " << options.resamples << " resamples of "
+      << ((options.block_length > 0) ? "blocks" : "ranges") << ", seed "
+      << options.seed << std::endl;
+}
@@ -0,0 +1,87 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef BOOTSTRAP_H_
+#define BOOTSTRAP_H_
+
+#include <ostream>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Bootstrap settings. With a block length of 0, predicted ranges (for
+// precision) and real ranges (for recall) are resampled independently.
+// Otherwise, the series is cut into blocks of that many labels, which are
+// resampled as a whole with all ranges starting in them, so that precision
+// and recall of a resample come from the same stretches of time.
+//-----------------------------------------------------------------------------
+struct bootstrap_options
+{
+  bootstrap_options()
+  : resamples(1000), block_length(0), confidence(0.95), seed(1), threads(0)
+  {}
+
+  unsigned resamples;
+  timestamp block_length;
+  double confidence;       // Of the intervals, in (0 .. 1)
+  unsigned long long seed; // Resample i draws from a generator seeded by
+                           // (seed, i), whatever the number of threads
+  unsigned threads;        // 0 for one per hardware thread
+};
+
+//-----------------------------------------------------------------------------
+// Metric of the original ranges and its percentile confidence interval.
+//-----------------------------------------------------------------------------
+struct confidence_interval
+{
+  double estimate;
+  double lower;
+  double upper;
+};
+
+struct bootstrap_result
+{
+  confidence_interval precision;
+  confidence_interval recall;
+  confidence_interval fscore; // Undefined F-Scores of resamples count as 0
+};
+
+//-----------------------------------------------------------------------------
+// Bootstraps the metrics of the evaluator's ranges, over a series of count
+// labels. Per-range rewards are computed once; resamples only re-weigh them.
+//-----------------------------------------------------------------------------
+bootstrap_result bootstrap(evaluator const &e, timestamp count,
+  bootstrap_options const &options);
+
+void write_bootstrap(std::ostream &out, bootstrap_result const &result,
+  bootstrap_options const &options);
+
+}
+
+#endif // BOOTSTRAP_H_
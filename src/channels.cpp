@@ -0,0 +1,162 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "channels.h"
+#include "point_evaluator.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace anomaly;
+
+//-----------------------------------------------------------------------------
+static size_t count_points(time_intervals const &anomalies)
+{
+  size_t points = 0;
+  for (auto r = anomalies.begin(); r != anomalies.end(); ++r)
+    points += r->second - r->first + 1;
+  return points;
+}
+
+//-----------------------------------------------------------------------------
+// Evaluates one channel like a single run of evaluate: classical (-c) and
+// numenta-like (-n) metrics with points, time series metrics (-t) with ranges.
+//-----------------------------------------------------------------------------
+static channel_result evaluate_channel(time_intervals const &real,
+  time_intervals const &predicted, timestamp count, evaluation_job const &job)
+{
+  channel_result result;
+
+  if (job.metric_option != "-t")
+  {
+    point_evaluator e(real, predicted, count, job.metric_option == "-c",
+                      job.beta, job.alpha_r, job.gamma, job.delta_p, 
+                      job.delta_r);
+    e.get_parameters().set_udfs(job.udfs);
+    e.update_precision();
+    e.update_recall();
+    e.update_fscore();
+
+    result.precision = e.get_precision();
+    result.recall = e.get_recall();
+    result.fscore = e.get_fscore();
+    result.precision_weight = count_points(predicted);
+    result.recall_weight = (job.metric_option == "-c") ? count_points(real)
+                                                        : real.size();
+    return result;
+  }
+
+  evaluator e(interval_span(real), interval_span(predicted), job.beta,
+              job.alpha_r, job.gamma, job.delta_p, job.delta_r);
+  e.set_udfs(job.udfs);
+  e.update_precision();
+  e.update_recall();
+  e.update_fscore();
+
+  result.precision = e.get_precision();
+  result.recall = e.get_recall();
+  result.fscore = e.get_fscore();
+  result.precision_weight = predicted.size();
+  result.recall_weight = real.size();
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+channel_summary anomaly::evaluate_channels(
+  std::vector<time_intervals> const &real,
+  std::vector<time_intervals> const &predicted, timestamp count,
+  evaluation_job const &job, unsigned threads)
+{
+  if (real.size() != predicted.size())
+    throw "Error: Number of columns are different!";
+  if (real.empty()) throw "Error: No columns!";
+
+  channel_summary summary;
+  summary.channels.resize(real.size());
+
+  thread_pool pool(std::min<size_t>(std::max(threads, 1u), real.size()));
+  for (size_t c = 0; c < real.size(); ++c)
+  {
+    pool.submit([&, c]
+    {
+      summary.channels[c] = evaluate_channel(real[c], predicted[c], count,
+                                             job);
+    });
+  }
+  pool.wait();
+
+  // Metrics are mean rewards, so micro averages weigh each channel by the
+  // number of ranges or points it averages over.
+  double precision_sum = 0, recall_sum = 0;
+  size_t precision_weight = 0, recall_weight = 0;
+  summary.macro_precision = summary.macro_recall = summary.macro_fscore = 0;
+  for (auto c = summary.channels.begin(); c != summary.channels.end(); ++c)
+  {
+    precision_sum += c->precision * c->precision_weight;
+    recall_sum += c->recall * c->recall_weight;
+    precision_weight += c->precision_weight;
+    recall_weight += c->recall_weight;
+
+    summary.macro_precision += c->precision;
+    summary.macro_recall += c->recall;
+    if (!std::isnan(c->fscore)) summary.macro_fscore += c->fscore;
+  }
+
+  size_t channels = summary.channels.size();
+  summary.macro_precision /= channels;
+  summary.macro_recall /= channels;
+  summary.macro_fscore /= channels;
+
+  evaluator params;
+  params.set_beta(job.beta);
+  summary.micro_precision = (precision_weight > 0) 
+                            ? precision_sum / precision_weight : 0.0;
+  summary.micro_recall = (recall_weight > 0) 
+                         ? recall_sum / recall_weight : 0.0;
+  summary.micro_fscore = params.compute_fscore(summary.micro_precision,
+                                               summary.micro_recall);
+  return summary;
+}
+
+//-----------------------------------------------------------------------------
+void anomaly::write_channels(std::ostream &out, channel_summary const &summary)
+{
+  for (size_t c = 0; c < summary.channels.size(); ++c)
+  {
+    channel_result const &r = summary.channels[c];
+    out << "Channel " << c + 1 << ": Precision = " << r.precision
+        << ", Recall = " << r.recall << ", F-Score = " << r.fscore 
+        << std::endl;
+  }
+
+  out << "Micro Precision = " << summary.micro_precision << std::endl;
+  out << "Micro Recall = " << summary.micro_recall << std::endl;
+  out << "Micro F-Score = " << summary.micro_fscore << std::endl;
+  out << "Macro Precision = " << summary.macro_precision << std::endl;
+  out << "Macro Recall = " << summary.macro_recall << std::endl;
+  out << "Macro F-Score = " << summary.macro_fscore << std::endl;
+}
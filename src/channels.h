@@ -0,0 +1,82 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef CHANNELS_H_
+#define CHANNELS_H_
+
+#include <ostream>
+#include <vector>
+
+#include "evaluator.h"
+#include "jobs.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Metrics of one channel (label column) of multi-column data files, and the
+// number of ranges or points each metric averages over.
+//-----------------------------------------------------------------------------
+struct channel_result
+{
+  double precision;
+  double recall;
+  double fscore;
+  size_t precision_weight;
+  size_t recall_weight;
+};
+
+//-----------------------------------------------------------------------------
+// Per-channel metrics with their micro averages (over the ranges or points
+// of all channels, as if they were one series) and macro averages (over the
+// channels, counting an undefined F-Score as 0).
+//-----------------------------------------------------------------------------
+struct channel_summary
+{
+  std::vector<channel_result> channels;
+
+  double micro_precision;
+  double micro_recall;
+  double micro_fscore;
+  double macro_precision;
+  double macro_recall;
+  double macro_fscore;
+};
+
+//-----------------------------------------------------------------------------
+// Evaluates every channel pair of real and predicted anomalies with the
+// metric and parameters of job (its file names are not used), on up to
+// "threads" threads.
+//-----------------------------------------------------------------------------
+channel_summary evaluate_channels(std::vector<time_intervals> const &real,
+  std::vector<time_intervals> const &predicted, timestamp count,
+  evaluation_job const &job, unsigned threads);
+
+void write_channels(std::ostream &out, channel_summary const &summary);
+
+}
+
+#endif // CHANNELS_H_
@@ -0,0 +1,213 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "contributions.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace anomaly;
+
+typedef unsigned long long u64;
+
+//-----------------------------------------------------------------------------
+// Output file with a large buffer of its own, written in big pieces.
+//-----------------------------------------------------------------------------
+class buffered_file
+{
+public:
+
+  explicit buffered_file(std::string const &path)
+  : file_(fopen(path.c_str(), "wb")), ok_(file_ != NULL)
+  {
+    if (file_ == NULL) throw "Error: Could not open file!";
+    buffer_.reserve(buffer_size);
+  }
+
+  ~buffered_file()
+  {
+    if (file_ != NULL) fclose(file_);
+  }
+
+  void put(char const *data, size_t size)
+  {
+    if (buffer_.size() + size > buffer_size) flush();
+    buffer_.insert(buffer_.end(), data, data + size);
+  }
+
+  void put_le(u64 value, int bytes)
+  {
+    char data[8];
+    for (int i = 0; i < bytes; ++i, value >>= 8) data[i] = (char)value;
+    put(data, bytes);
+  }
+
+  void put_double(double value)
+  {
+    u64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_le(bits, 8);
+  }
+
+  void close()
+  {
+    flush();
+    ok_ = (fclose(file_) == 0) && ok_;
+    file_ = NULL;
+    if (!ok_) throw "Error: Could not write file!";
+  }
+
+private:
+
+  buffered_file(buffered_file const &);
+  buffered_file & operator=(buffered_file const &);
+
+  static const size_t buffer_size = 1 << 20;
+
+  void flush()
+  {
+    if (buffer_.empty()) return;
+    ok_ = (fwrite(&buffer_[0], 1, buffer_.size(), file_) == buffer_.size()) &&
+          ok_;
+    buffer_.clear();
+  }
+
+  FILE *file_;
+  bool ok_;
+  std::vector<char> buffer_;
+};
+
+//-----------------------------------------------------------------------------
+// Staged computation of one metric: the terms of every range, and their
+// contributions.
+//-----------------------------------------------------------------------------
+struct metric_breakdown
+{
+  interval_span ranges;
+  std::vector<range_terms> terms;
+  std::vector<range_contribution> contributions;
+};
+
+//-----------------------------------------------------------------------------
+// Returns the metric, the mean reward, summed in range order like
+// compute_metric().
+//-----------------------------------------------------------------------------
+static double break_down(evaluator const &e, e_metric m,
+  metric_breakdown &breakdown)
+{
+  overlap_table table;
+  e.compute_overlaps(m, table);
+  e.compute_terms(m, table, breakdown.terms);
+  breakdown.ranges = (m == e_precision) ? e.get_predicted_anomalies()
+                                        : e.get_real_anomalies();
+
+  size_t n = breakdown.terms.size();
+  double sum = 0.0;
+  breakdown.contributions.resize(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    breakdown.contributions[i] = e.compute_contribution(m, 
+                                                        breakdown.terms[i]);
+    sum += breakdown.contributions[i].reward;
+  }
+
+  return (n > 0) ? sum / n : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+static void write_csv(buffered_file &out, char const *metric,
+  metric_breakdown const &breakdown)
+{
+  char row[256];
+  for (size_t i = 0; i < breakdown.terms.size(); ++i)
+  {
+    range_contribution const &c = breakdown.contributions[i];
+    int n = snprintf(row, sizeof(row), "%s,%lld,%lld,%lld,%.17g,%.17g,%.17g,"
+                     "%.17g\n", metric, (long long)breakdown.ranges[i].first,
+                     (long long)breakdown.ranges[i].second,
+                     (long long)breakdown.terms[i].overlap_count, 
+                     breakdown.terms[i].omega_reward, c.gamma,
+                     c.existence_reward, c.reward);
+    out.put(row, n);
+  }
+}
+
+//-----------------------------------------------------------------------------
+static void write_columns(buffered_file &out,
+  metric_breakdown const &breakdown)
+{
+  size_t n = breakdown.terms.size();
+
+  for (size_t i = 0; i < n; ++i) out.put_le(breakdown.ranges[i].first, 8);
+  for (size_t i = 0; i < n; ++i) out.put_le(breakdown.ranges[i].second, 8);
+  for (size_t i = 0; i < n; ++i) 
+    out.put_le(breakdown.terms[i].overlap_count, 8);
+  for (size_t i = 0; i < n; ++i) 
+    out.put_double(breakdown.terms[i].omega_reward);
+  for (size_t i = 0; i < n; ++i) 
+    out.put_double(breakdown.contributions[i].gamma);
+  for (size_t i = 0; i < n; ++i) 
+    out.put_double(breakdown.contributions[i].existence_reward);
+  for (size_t i = 0; i < n; ++i) 
+    out.put_double(breakdown.contributions[i].reward);
+}
+
+//-----------------------------------------------------------------------------
+void anomaly::export_contributions(evaluator const &e,
+  std::string const &path, contribution_format format, double &precision,
+  double &recall)
+{
+  buffered_file out(path);
+  metric_breakdown breakdown;
+
+  if (format == e_contributions_csv)
+  {
+    static const char header[] = "metric,start,end,overlap_count,"
+                                 "omega_reward,gamma,existence_reward,"
+                                 "reward\n";
+    out.put(header, sizeof(header) - 1);
+
+    precision = break_down(e, e_precision, breakdown);
+    write_csv(out, "precision", breakdown);
+    recall = break_down(e, e_recall, breakdown);
+    write_csv(out, "recall", breakdown);
+  }
+  else
+  {
+    out.put(contribution_file_magic, sizeof(contribution_file_magic));
+    out.put_le(contribution_file_version, 4);
+    out.put_le(e.get_predicted_anomalies().size(), 8);
+    out.put_le(e.get_real_anomalies().size(), 8);
+
+    precision = break_down(e, e_precision, breakdown);
+    write_columns(out, breakdown);
+    recall = break_down(e, e_recall, breakdown);
+    write_columns(out, breakdown);
+  }
+
+  out.close();
+}
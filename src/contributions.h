@@ -0,0 +1,76 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef CONTRIBUTIONS_H_
+#define CONTRIBUTIONS_H_
+
+#include <string>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Per-range contributions to precision (one row per predicted range) and
+// recall (one row per real range): bounds, overlap count, omega reward,
+// gamma factor, existence reward and the range's reward, whose mean is the
+// metric (see range_contribution).
+//
+// CSV files have the header
+//
+//   metric,start,end,overlap_count,omega_reward,gamma,existence_reward,reward
+//
+// with metric "precision" or "recall". Binary files are columnar (all
+// integers and doubles little-endian):
+//
+//   offset  size  field
+//   0       4     magic "TSAR"
+//   4       4     format version (currently 1)
+//   8       8     number of predicted ranges P
+//   16      8     number of real ranges R
+//   24      ...   the precision section, with P values per column, then the
+//                 recall section, with R values per column
+//
+// Each section holds the columns start, end, overlap_count (int64), then
+// omega_reward, gamma, existence_reward and reward (float64), one after the
+// other.
+//-----------------------------------------------------------------------------
+typedef enum {e_contributions_csv, e_contributions_binary} contribution_format;
+
+static const char contribution_file_magic[4] = {'T', 'S', 'A', 'R'};
+static const unsigned contribution_file_version = 1;
+
+//-----------------------------------------------------------------------------
+// Computes precision and recall of e with its staged computation and writes
+// the contributions of all ranges in the same pass, through a buffer.
+//-----------------------------------------------------------------------------
+void export_contributions(evaluator const &e, std::string const &path,
+  contribution_format format, double &precision, double &recall);
+
+}
+
+#endif // CONTRIBUTIONS_H_
@@ -0,0 +1,295 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "decompress.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef TSAD_ZLIB
+#include <zlib.h>
+#endif
+#ifdef TSAD_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace anomaly;
+
+//-----------------------------------------------------------------------------
+compression anomaly::detect_compression(char const *data, size_t size)
+{
+  unsigned char const *bytes = (unsigned char const *)data;
+
+  if ((size >= 2) && (bytes[0] == 0x1f) && (bytes[1] == 0x8b))
+    return e_gzip;
+  if ((size >= 4) && (bytes[0] == 0x28) && (bytes[1] == 0xb5) && 
+      (bytes[2] == 0x2f) && (bytes[3] == 0xfd))
+    return e_zstd;
+  return e_uncompressed;
+}
+
+//-----------------------------------------------------------------------------
+decompressor::decompressor(char const *data, size_t size)
+: format_(detect_compression(data, size)), data_(data), size_(size), 
+  finished_(false), stop_(false), offset_(0)
+{
+  start();
+}
+
+//-----------------------------------------------------------------------------
+decompressor::decompressor(std::vector<char> const &head,
+  byte_source const &read_more)
+: format_(detect_compression(head.data(), head.size())), head_(head), 
+  data_(head_.data()), size_(head_.size()), read_more_(read_more), 
+  finished_(false), stop_(false), offset_(0)
+{
+  start();
+}
+
+//-----------------------------------------------------------------------------
+decompressor::~decompressor()
+{
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    stop_ = true;
+  }
+  changed_.notify_all();
+  if (thread_.joinable()) thread_.join();
+}
+
+//-----------------------------------------------------------------------------
+void decompressor::start()
+{
+#ifndef TSAD_ZLIB
+  if (format_ == e_gzip) 
+    throw "Error: gzip files are not supported by this build (no zlib)!";
+#endif
+#ifndef TSAD_ZSTD
+  if (format_ == e_zstd)
+    throw "Error: zstd files are not supported by this build (no libzstd)!";
+#endif
+  if (format_ == e_uncompressed) throw "Error: File is not compressed!";
+
+  thread_ = std::thread(&decompressor::run, this);
+}
+
+//-----------------------------------------------------------------------------
+size_t decompressor::read(char *buffer, size_t size)
+{
+  size_t copied = 0;
+
+  while (copied < size)
+  {
+    if (offset_ == current_.size())
+    {
+      if (copied > 0) break; // Hand out what is there rather than wait
+
+      std::unique_lock<std::mutex> guard(lock_);
+      changed_.wait(guard, [this] 
+        { return !chunks_.empty() || finished_ || error_; });
+      if (error_) std::rethrow_exception(error_);
+      if (chunks_.empty()) break; // Finished
+
+      current_.swap(chunks_.front());
+      chunks_.pop_front();
+      offset_ = 0;
+      changed_.notify_all();
+    }
+
+    size_t n = std::min(size - copied, current_.size() - offset_);
+    memcpy(buffer + copied, &current_[offset_], n);
+    offset_ += n;
+    copied += n;
+  }
+
+  return copied;
+}
+
+//-----------------------------------------------------------------------------
+void decompressor::run()
+{
+  try
+  {
+    if (format_ == e_gzip) inflate_gzip();
+    else decompress_zstd();
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    error_ = std::current_exception();
+  }
+
+  std::lock_guard<std::mutex> guard(lock_);
+  finished_ = true;
+  changed_.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+// Points data at the next compressed bytes and returns their number, 0 at
+// the end of the input.
+//-----------------------------------------------------------------------------
+size_t decompressor::read_input(char const *&data)
+{
+  if (size_ > 0)
+  {
+    data = data_;
+    size_t n = size_;
+    size_ = 0;
+    return n;
+  }
+  if (!read_more_) return 0;
+
+  input_.resize(1 << 16);
+  data = &input_[0];
+  return read_more_(&input_[0], input_.size());
+}
+
+//-----------------------------------------------------------------------------
+// Queues a decompressed chunk, waiting while the reader is max_chunks
+// behind. Returns false if the reader has gone.
+//-----------------------------------------------------------------------------
+bool decompressor::put(std::vector<char> &chunk)
+{
+  std::unique_lock<std::mutex> guard(lock_);
+  changed_.wait(guard, [this] 
+    { return (chunks_.size() < max_chunks) || stop_; });
+  if (stop_) return false;
+
+  chunks_.push_back(std::vector<char>());
+  chunks_.back().swap(chunk);
+  changed_.notify_all();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Inflates all gzip members of the input, one after the other.
+//-----------------------------------------------------------------------------
+void decompressor::inflate_gzip()
+{
+#ifdef TSAD_ZLIB
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (inflateInit2(&stream, 15 + 16) != Z_OK)
+    throw "Error: Could not start decompression!";
+
+  std::vector<char> chunk;
+  bool member_done = false;
+  bool more_output = false; // Output was full, inflate may have more
+  try
+  {
+    while (true)
+    {
+      // A member that ended exactly as the output filled up has no more
+      // output; only input tells whether another member follows.
+      if ((stream.avail_in == 0) && (!more_output || member_done))
+      {
+        char const *data = NULL;
+        size_t n = read_input(data);
+        if (n == 0) break;
+        stream.next_in = (Bytef *)data;
+        stream.avail_in = n;
+      }
+
+      if (member_done) // Another member follows
+      {
+        inflateReset(&stream);
+        member_done = false;
+      }
+
+      chunk.resize(chunk_size);
+      stream.next_out = (Bytef *)&chunk[0];
+      stream.avail_out = chunk.size();
+
+      int status = inflate(&stream, Z_NO_FLUSH);
+      if ((status != Z_OK) && (status != Z_STREAM_END) && 
+          (status != Z_BUF_ERROR))
+        throw "Error: Corrupt compressed file!";
+      if (status == Z_STREAM_END) member_done = true;
+      more_output = (stream.avail_out == 0);
+
+      chunk.resize(chunk_size - stream.avail_out);
+      if (!chunk.empty() && !put(chunk)) break;
+    }
+  }
+  catch (...)
+  {
+    inflateEnd(&stream);
+    throw;
+  }
+  inflateEnd(&stream);
+
+  if (!member_done) throw "Error: Truncated compressed file!";
+#endif
+}
+
+//-----------------------------------------------------------------------------
+void decompressor::decompress_zstd()
+{
+#ifdef TSAD_ZSTD
+  ZSTD_DStream *stream = ZSTD_createDStream();
+  if (stream == NULL) throw "Error: Could not start decompression!";
+
+  std::vector<char> chunk;
+  size_t status = 0;
+  bool more_output = false; // Output was full, zstd may have more
+  try
+  {
+    ZSTD_initDStream(stream);
+    ZSTD_inBuffer in = {NULL, 0, 0};
+    while (true)
+    {
+      // Status 0 means the frame was decoded and flushed: calling again
+      // without input would only ask for the header of a next frame.
+      if ((in.pos == in.size) && (!more_output || (status == 0)))
+      {
+        char const *data = NULL;
+        size_t n = read_input(data);
+        if (n == 0) break;
+        in.src = data;
+        in.size = n;
+        in.pos = 0;
+      }
+
+      chunk.resize(chunk_size);
+      ZSTD_outBuffer out = {&chunk[0], chunk.size(), 0};
+      status = ZSTD_decompressStream(stream, &out, &in);
+      if (ZSTD_isError(status)) throw "Error: Corrupt compressed file!";
+      more_output = (out.pos == out.size);
+
+      chunk.resize(out.pos);
+      if (!chunk.empty() && !put(chunk)) break;
+    }
+  }
+  catch (...)
+  {
+    ZSTD_freeDStream(stream);
+    throw;
+  }
+  ZSTD_freeDStream(stream);
+
+  if (status != 0) throw "Error: Truncated compressed file!";
+#endif
+}
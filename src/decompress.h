@@ -0,0 +1,111 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef DECOMPRESS_H_
+#define DECOMPRESS_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace anomaly
+{
+
+typedef enum {e_uncompressed, e_gzip, e_zstd} compression;
+
+// Compression of a file from its first bytes (at least 4 to tell).
+compression detect_compression(char const *data, size_t size);
+
+//-----------------------------------------------------------------------------
+// Streaming decompression of a gzip (with zlib, TSAD_ZLIB) or zstd (with
+// libzstd, TSAD_ZSTD) file on a thread of its own, which stays a few chunks
+// ahead of the reader, so that decompression overlaps with parsing. The
+// decompressed data is never held in memory as a whole.
+//
+// The compressed input is either a buffer (e.g. a mapped file), which must
+// stay valid until the decompressor is destroyed, or the first bytes already
+// read from a stream, followed by what read_more(buffer, size) returns until
+// it returns 0. read_more is called on the decompression thread.
+//-----------------------------------------------------------------------------
+class decompressor
+{
+public:
+
+  typedef std::function<size_t(char *, size_t)> byte_source;
+
+  decompressor(char const *data, size_t size);
+  decompressor(std::vector<char> const &head, byte_source const &read_more);
+  ~decompressor();
+
+  // Copies up to size decompressed bytes to buffer and returns their number,
+  // 0 at the end of the data. Errors of the decompression thread, such as
+  // corrupt input, are rethrown here.
+  size_t read(char *buffer, size_t size);
+
+private:
+
+  decompressor(decompressor const &);
+  decompressor & operator=(decompressor const &);
+
+  static const size_t chunk_size = 1 << 18;
+  static const size_t max_chunks = 4; // Decompressed ahead of the reader
+
+  void start();
+  void run();
+  size_t read_input(char const *&data);
+  bool put(std::vector<char> &chunk);
+  void inflate_gzip();
+  void decompress_zstd();
+
+  compression format_;
+
+  std::vector<char> head_; // Compressed bytes before those of read_more_
+  char const *data_;       // Compressed bytes not yet consumed
+  size_t size_;
+  byte_source read_more_;  // Empty if data_ holds all of the input
+  std::vector<char> input_;
+
+  std::mutex lock_;
+  std::condition_variable changed_;
+  std::deque<std::vector<char> > chunks_;
+  bool finished_;
+  bool stop_;
+  std::exception_ptr error_;
+
+  std::vector<char> current_; // Chunk being read
+  size_t offset_;
+
+  std::thread thread_;
+};
+
+}
+
+#endif // DECOMPRESS_H_
@@ -0,0 +1,134 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#include "delta_cache.h"
+
+using namespace anomaly;
+
+//-----------------------------------------------------------------------------
+delta_cache::prefix_sums_ptr delta_cache::find(int metric,
+  long long anomaly_length)
+{
+  std::lock_guard<std::mutex> guard(lock_);
+
+  auto i = index_.find(make_key(metric, anomaly_length));
+  if (i == index_.end())
+  {
+    ++misses_;
+    return prefix_sums_ptr();
+  }
+
+  ++hits_;
+  entries_.splice(entries_.begin(), entries_, i->second); // Mark as recent.
+  return i->second->second;
+}
+
+//-----------------------------------------------------------------------------
+delta_cache::prefix_sums_ptr delta_cache::insert(int metric,
+  long long anomaly_length, prefix_sums &values)
+{
+  if (values.size() > get_capacity()) return prefix_sums_ptr();
+
+  std::shared_ptr<prefix_sums> stored(new prefix_sums);
+  stored->swap(values);
+
+  std::lock_guard<std::mutex> guard(lock_);
+
+  key_type key = make_key(metric, anomaly_length);
+  auto i = index_.find(key);
+  if (i != index_.end()) // Another thread got here first.
+  {
+    size_ -= i->second->second->size();
+    entries_.erase(i->second);
+    index_.erase(i);
+  }
+
+  evict(stored->size());
+
+  entries_.push_front(entry(key, stored));
+  index_[key] = entries_.begin();
+  size_ += stored->size();
+
+  return stored;
+}
+
+//-----------------------------------------------------------------------------
+// Drops least recently used entries until "needed" more values fit. Callers
+// must hold the lock.
+//-----------------------------------------------------------------------------
+void delta_cache::evict(size_t needed)
+{
+  while (!entries_.empty() && (size_ + needed > capacity_))
+  {
+    size_ -= entries_.back().second->size();
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void delta_cache::clear()
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  entries_.clear();
+  index_.clear();
+  size_ = 0;
+}
+
+//-----------------------------------------------------------------------------
+void delta_cache::set_capacity(size_t capacity)
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  capacity_ = capacity;
+  evict(0);
+}
+
+//-----------------------------------------------------------------------------
+size_t delta_cache::get_capacity() const
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  return capacity_;
+}
+
+//-----------------------------------------------------------------------------
+size_t delta_cache::get_size() const
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  return size_;
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long delta_cache::get_hits() const
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  return hits_;
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long delta_cache::get_misses() const
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  return misses_;
+}
@@ -0,0 +1,117 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#ifndef DELTA_CACHE_H_
+#define DELTA_CACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Least-recently-used cache of positional bias prefix sums, keyed by
+// (metric, anomaly length). An entry for length L holds L+1 values where
+// entry k is the sum of delta(1) .. delta(k), so that the bias of any
+// overlap within a range of length L is the difference of two entries.
+// Memory is bounded by the total number of cached values. The cache may be
+// shared by several threads; entries handed out stay valid while in use.
+//-----------------------------------------------------------------------------
+class delta_cache
+{
+public:
+
+  typedef std::vector<double> prefix_sums;
+  typedef std::shared_ptr<prefix_sums const> prefix_sums_ptr;
+
+  static const size_t default_capacity = 1 << 22; // 32 MiB of doubles
+
+  explicit delta_cache(size_t capacity = default_capacity)
+  : capacity_(capacity), size_(0), hits_(0), misses_(0)
+  {}
+
+  // Copies share the capacity but start out empty.
+  delta_cache(delta_cache const &other)
+  : capacity_(other.get_capacity()), size_(0), hits_(0), misses_(0)
+  {}
+
+  delta_cache & operator=(delta_cache const &other)
+  {
+    if (this != &other)
+    {
+      clear();
+      set_capacity(other.get_capacity());
+    }
+    return *this;
+  }
+
+  // Returns the cached prefix sums, or NULL (and counts a miss) if absent.
+  prefix_sums_ptr find(int metric, long long anomaly_length);
+
+  // Stores prefix sums for a key, evicting the least recently used entries
+  // as needed. Returns NULL if the entry alone exceeds the capacity.
+  prefix_sums_ptr insert(int metric, long long anomaly_length,
+    prefix_sums &values);
+
+  void clear();
+  void set_capacity(size_t capacity);
+
+  size_t get_capacity() const;
+  size_t get_size() const;
+  unsigned long long get_hits() const;
+  unsigned long long get_misses() const;
+
+private:
+
+  typedef unsigned long long key_type;
+  typedef std::pair<key_type, prefix_sums_ptr> entry;
+
+  static key_type make_key(int metric, long long anomaly_length)
+  {
+    return ((key_type)anomaly_length << 2) | (key_type)(metric & 3);
+  }
+
+  void evict(size_t needed);
+
+  size_t capacity_; // Maximum number of cached values
+  size_t size_;     // Current number of cached values
+
+  unsigned long long hits_;
+  unsigned long long misses_;
+
+  mutable std::mutex lock_;
+  std::list<entry> entries_; // Most recently used first
+  std::unordered_map<key_type, std::list<entry>::iterator> index_;
+};
+
+}
+
+#endif // DELTA_CACHE_H_
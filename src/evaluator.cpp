@@ -25,18 +25,36 @@ SOFTWARE.
 */
 
 #include "evaluator.h"
+#include "thread_pool.h"
+#include "stats.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 
 using namespace anomaly;
 
+static const size_t shard_size = 1 << 14; // Outer ranges per parallel shard
+
+//-----------------------------------------------------------------------------
+void evaluator::own_anomalies(time_intervals const &real,
+  time_intervals const &predicted)
+{
+  owned_real_ = std::make_shared<time_intervals const>(real);
+  owned_predicted_ = std::make_shared<time_intervals const>(predicted);
+  real_anomalies_ = interval_span(*owned_real_);
+  predicted_anomalies_ = interval_span(*owned_predicted_);
+}
+
 //-----------------------------------------------------------------------------
 void evaluator::print_real_anomalies()
 {
   std::cout << "Real Anomalies:" << std::endl;
   for (auto i = real_anomalies_.begin(); i != real_anomalies_.end(); ++i) 
   {
-      std::cout << "[" << i->first << ", " << i->second << "]" << std::endl;
+      std::cout << "[" << i->first << ", " << i->second << "]\n";
   }
 }
 
@@ -47,7 +65,7 @@ void evaluator::print_predicted_anomalies()
   for (auto i = predicted_anomalies_.begin(); 
     i != predicted_anomalies_.end(); ++i) 
   {
-      std::cout << "[" << i->first << ", " << i->second << "]" << std::endl;
+      std::cout << "[" << i->first << ", " << i->second << "]\n";
   }
 }
 
@@ -58,7 +76,7 @@ void evaluator::print_predicted_anomalies()
 // number of distinct overlap ranges between a given range and a sequence of
 // ranges.
 //-----------------------------------------------------------------------------
-double evaluator::udf_gamma_def(int overlap_count, e_metric m) const
+double evaluator::udf_gamma_def(timestamp overlap_count, e_metric m) const
 {
   double return_val = 1.0; // Default return value is 1. 
 
@@ -109,8 +127,55 @@ double evaluator::udf_delta_def(timestamp t, timestamp anomaly_length,
 }
 
 //-----------------------------------------------------------------------------
-double evaluator::gamma_select(overlap_cardinality const &gamma, int overlap,
-  e_metric m, std::string const &prec_or_recall) const
+// The user-defined gamma of a plugin if one is set, udf_gamma_def() otherwise.
+//-----------------------------------------------------------------------------
+double evaluator::udf_gamma(timestamp overlap, e_metric m) const
+{
+  if (udfs_.gamma == NULL) return udf_gamma_def(overlap, m);
+
+  TSAD_COUNT(c_udf_calls, 1);
+  double value = udfs_.gamma(m, overlap);
+  if (!(value >= 1.0)) throw "Error: User-defined gamma returned a value < 1!";
+  return value;
+}
+
+//-----------------------------------------------------------------------------
+// Fills values[0 .. anomaly_length-1] with the user-defined delta of every
+// position, from one batch call to a plugin if one is set.
+//-----------------------------------------------------------------------------
+void evaluator::udf_delta(timestamp anomaly_length, e_metric m, 
+  double *values) const
+{
+  tsad_udf_delta delta = (m == e_precision) ? udfs_.delta_p : udfs_.delta_r;
+  timestamp t;
+
+  if (delta == NULL)
+  {
+    for (t = 1; t <= anomaly_length; ++t)
+      values[t - 1] = udf_delta_def(t, anomaly_length, m);
+    return;
+  }
+
+  TSAD_COUNT(c_udf_calls, 1);
+  if (delta(m, anomaly_length, values) != 0)
+    throw "Error: User-defined delta failed!";
+  for (t = 0; t < anomaly_length; ++t)
+  {
+    if (!(values[t] > 0)) 
+      throw "Error: User-defined delta returned a value <= 0!";
+  }
+}
+
+//-----------------------------------------------------------------------------
+static char const *metric_name(e_metric m)
+{
+  return (m == e_precision) ? "precision" : "recall";
+}
+
+//-----------------------------------------------------------------------------
+double evaluator::gamma_select(overlap_cardinality const &gamma, 
+  timestamp overlap,
+  e_metric m) const
 {
   switch (gamma)
   {
@@ -119,24 +184,24 @@ double evaluator::gamma_select(overlap_cardinality const &gamma, int overlap,
     case e_reciprocal:
       return ((overlap > 1) ? 1.0/overlap : 1.0);
     case e_udf_gamma:
-      return ((overlap > 1) ? 1.0/udf_gamma_def(overlap, m) : 1.0);
+      return ((overlap > 1) ? 1.0/udf_gamma(overlap, m) : 1.0);
     default:
       std::cout << "Warning: Invalid overlap cardinality function for " 
-                << prec_or_recall.c_str() << " = " << gamma << std::endl;
+                << metric_name(m) << " = " << gamma << std::endl;
       std::cout << "... using default value \"one\" instead..." << std::endl;
       return 1.0;
   }
 }
 
 //-----------------------------------------------------------------------------
-double evaluator::gamma_function(int overlap, e_metric m) const
+double evaluator::gamma_function(timestamp overlap, e_metric m) const
 {
   switch (m)
   {
     case e_precision:
-      return gamma_select(gamma_p_, overlap, m, "precision");
+      return gamma_select(gamma_p_, overlap, m);
     case e_recall:
-      return gamma_select(gamma_r_, overlap, m, "recall");
+      return gamma_select(gamma_r_, overlap, m);
     default:
       std::cout << "Warning: Invalid metric \"" << m << "\" in gamma_function" 
                 << std::endl << "...ignoring..." << std::endl;
@@ -144,9 +209,12 @@ double evaluator::gamma_function(int overlap, e_metric m) const
   }
 }
 
+//-----------------------------------------------------------------------------
+// Built-in biases only: omega_function() fetches a user-defined bias with one
+// batch call per range instead of one per position.
 //-----------------------------------------------------------------------------
 double evaluator::delta_select(positional_bias const &delta, timestamp t, 
-  timestamp anomaly_length, e_metric m, std::string const &prec_or_recall) const
+  timestamp anomaly_length, e_metric m) const
 {
   switch (delta)
   {
@@ -159,11 +227,9 @@ double evaluator::delta_select(positional_bias const &delta, timestamp t,
                                       : (double)(anomaly_length - t + 1));
     case e_back:
       return (double)t;
-    case e_udf_delta:
-      return udf_delta_def(t, anomaly_length, m);
     default:
       std::cout << "Warning: Invalid positional bias for " 
-                << prec_or_recall.c_str() << " = " << delta << std::endl
+                << metric_name(m) << " = " << delta << std::endl
                 << "...ignoring and using default value \"flat\" instead..." 
                 << std::endl;
       return 1.0;
@@ -174,12 +240,13 @@ double evaluator::delta_select(positional_bias const &delta, timestamp t,
 double evaluator::delta_function(timestamp t, timestamp anomaly_length, 
   e_metric m) const
 {
+  TSAD_COUNT(c_delta_calls, 1);
   switch (m)
   {
     case e_precision: 
-      return delta_select(delta_p_, t, anomaly_length, m, "precision");
+      return delta_select(delta_p_, t, anomaly_length, m);
     case e_recall: 
-      return delta_select(delta_r_, t, anomaly_length, m, "recall");
+      return delta_select(delta_r_, t, anomaly_length, m);
     default:
       std::cout << "Warning: Invalid metric \"" << m << "\" in delta_function" 
                 << std::endl << "...ignoring..." << std::endl;
@@ -187,6 +254,168 @@ double evaluator::delta_function(timestamp t, timestamp anomaly_length,
   }
 }
 
+//-----------------------------------------------------------------------------
+// Policy version of gamma_select() for a gamma known at compile time. The
+// switch is on a template parameter, so every instantiation reduces to a
+// single case. Only valid values are instantiated.
+//-----------------------------------------------------------------------------
+template <overlap_cardinality Gamma>
+double evaluator::gamma_policy(timestamp overlap, e_metric m) const
+{
+  switch (Gamma)
+  {
+    case e_one:
+      return 1.0;
+    case e_reciprocal:
+      return ((overlap > 1) ? 1.0/overlap : 1.0);
+    default:
+      return ((overlap > 1) ? 1.0/udf_gamma(overlap, m) : 1.0);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Closed form of the sum of delta_select(bias, t, anomaly_length) over the
+// positions t in [a .. b], for the built-in positional biases. The sums are
+// kept in integer arithmetic, so they are exactly the values that the
+// position-by-position loop would accumulate in double precision.
+//-----------------------------------------------------------------------------
+template <positional_bias Bias>
+static position_sum bias_sum(position_sum anomaly_length, position_sum a, 
+  position_sum b)
+{
+  position_sum half = anomaly_length / 2;
+  position_sum back_start = std::max(a, half + 1);
+
+  switch (Bias)
+  {
+    case e_flat:
+      return b - a + 1;
+    case e_front:
+      return (anomaly_length + 1) * (b - a + 1) - series_sum(a, b);
+    case e_middle: // Rising up to half, falling after it.
+      return series_sum(a, std::min(b, half)) +
+             ((b < back_start) ? 0 : 
+              (anomaly_length + 1) * (b - back_start + 1) - 
+              series_sum(back_start, b));
+    case e_back:
+      return series_sum(a, b);
+    default:
+      assert(false);
+      return 0;
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Prefix sums of the user-defined delta over a range of the given length,
+// computed once per (metric, length) and then served from udf_cache_.
+// Returns NULL if the range is too long to be cached.
+//-----------------------------------------------------------------------------
+delta_cache::prefix_sums_ptr evaluator::udf_prefix_sums(
+  timestamp anomaly_length, e_metric m) const
+{
+  delta_cache::prefix_sums_ptr cached = udf_cache_.find(m, anomaly_length);
+  if (cached) return cached;
+
+  if ((size_t)anomaly_length + 1 > udf_cache_.get_capacity()) return cached;
+
+  delta_cache::prefix_sums values(anomaly_length + 1);
+  values[0] = 0;
+  udf_delta(anomaly_length, m, &values[1]);
+  for (timestamp i = 1; i <= anomaly_length; ++i)
+  {
+    values[i] = values[i - 1] + values[i];
+  }
+
+  return udf_cache_.insert(m, anomaly_length, values);
+}
+
+//-----------------------------------------------------------------------------
+// Same as udf_prefix_sums(anomaly_length, m), looked up in memo first. The
+// sums stay valid until the next lookup in memo. Never NULL: ranges too long
+// to be cached are summed into memo.uncached.
+//-----------------------------------------------------------------------------
+delta_cache::prefix_sums const * evaluator::udf_prefix_sums(
+  timestamp anomaly_length, e_metric m, udf_memo &memo) const
+{
+  size_t slot = (size_t)anomaly_length % udf_memo::slots;
+  if (memo.lengths[slot] == anomaly_length)
+  {
+    memo.current = memo.sums[slot].lock();
+    if (memo.current) return memo.current.get();
+  }
+
+  memo.current = udf_prefix_sums(anomaly_length, m);
+  if (!memo.current)
+  {
+    memo.uncached.resize(anomaly_length + 1);
+    memo.uncached[0] = 0;
+    udf_delta(anomaly_length, m, &memo.uncached[1]);
+    for (timestamp i = 1; i <= anomaly_length; ++i)
+    {
+      memo.uncached[i] = memo.uncached[i - 1] + memo.uncached[i];
+    }
+    return &memo.uncached;
+  }
+
+  memo.sums[slot] = memo.current;
+  memo.lengths[slot] = anomaly_length;
+  return memo.current.get();
+}
+
+//-----------------------------------------------------------------------------
+// Built-in biases take the O(1) closed form and the user-defined one the
+// given prefix sums of the range's length; positions are 1-based in the
+// range. Only a user-defined bias over a range too long to be cached (NULL
+// prefix sums) is summed position by position, in a buffer kept per thread.
+//-----------------------------------------------------------------------------
+template <positional_bias Delta>
+double evaluator::omega_function(time_range range, time_range overlap, 
+  e_metric m, delta_cache::prefix_sums const *prefix) const
+{ 
+  timestamp anomaly_length = range.second - range.first + 1;
+  double my_positional_bias = 0, max_positional_bias = 0, temp_bias = 0;
+  timestamp i, j;
+
+  TSAD_COUNT(c_omega_evaluations, 1);
+  if (Delta != e_udf_delta)
+  {
+    max_positional_bias = (double)bias_sum<Delta>(anomaly_length,
+                                                  1, anomaly_length);
+    my_positional_bias = (double)bias_sum<Delta>(anomaly_length,
+                                       overlap.first - range.first + 1,
+                                       overlap.second - range.first + 1);
+  }
+  else if (prefix != NULL)
+  {
+    max_positional_bias = (*prefix)[anomaly_length];
+    my_positional_bias = (*prefix)[overlap.second - range.first + 1] -
+                         (*prefix)[overlap.first - range.first];
+  }
+  else
+  {
+    static thread_local std::vector<double> values;
+    values.resize(anomaly_length);
+    udf_delta(anomaly_length, m, values.data());
+
+    for (i = 1; i <= anomaly_length; ++i)
+    {
+      temp_bias = values[i - 1];
+      max_positional_bias += temp_bias;
+
+      j = range.first + i - 1;
+      if ((j >= overlap.first) && (j <= overlap.second))
+      {
+        my_positional_bias = my_positional_bias + temp_bias;
+      }
+    }
+  }
+
+  if (max_positional_bias > 0)
+    return my_positional_bias / max_positional_bias;
+  else
+    return 0;
+}    
+
 //-----------------------------------------------------------------------------
 double evaluator::omega_function(time_range range, time_range overlap, 
   e_metric m) const
@@ -195,6 +424,32 @@ double evaluator::omega_function(time_range range, time_range overlap,
   double my_positional_bias = 0, max_positional_bias = 0, temp_bias = 0;
   timestamp i, j;
 
+  if ((engine_ != e_nested) && ((m == e_precision) || (m == e_recall)))
+  {
+    switch ((m == e_precision) ? delta_p_ : delta_r_)
+    {
+      case e_flat:
+        return omega_function<e_flat>(range, overlap, m, NULL);
+      case e_front:
+        return omega_function<e_front>(range, overlap, m, NULL);
+      case e_middle:
+        return omega_function<e_middle>(range, overlap, m, NULL);
+      case e_back:
+        return omega_function<e_back>(range, overlap, m, NULL);
+      case e_udf_delta:
+        return omega_function<e_udf_delta>(range, overlap, m,
+          udf_prefix_sums(range.second - range.first + 1, m).get());
+      default:
+        break;
+    }
+  }
+
+  // The reference engine sums position by position, a user-defined bias from
+  // one batch call. Invalid metric or bias: let delta_function() warn.
+  if (((m == e_precision) ? delta_p_ : delta_r_) == e_udf_delta)
+    return omega_function<e_udf_delta>(range, overlap, m, NULL);
+
+  TSAD_COUNT(c_omega_evaluations, 1);
   for (i = 1; i <= anomaly_length; ++i)
   {
     temp_bias = delta_function(i, anomaly_length, m);
@@ -214,90 +469,515 @@ double evaluator::omega_function(time_range range, time_range overlap,
 }    
 
 //-----------------------------------------------------------------------------
-double evaluator::compute_omega_reward(time_range r1, time_range r2,
-  int& overlap_count, e_metric m) const
+bool evaluator::has_builtin_bias(e_metric m) const
 {
-  if ((r1.second < r2.first) || (r1.first > r2.second)) return 0; // No overlap
-  else 
+  positional_bias delta = (m == e_precision) ? delta_p_ : delta_r_;
+  return (delta == e_flat) || (delta == e_front) || (delta == e_middle) ||
+         (delta == e_back);
+}
+
+//-----------------------------------------------------------------------------
+// The bias is t, or L+1-t, or either one by half of the range, so its sum
+// over the positions is linear in their number and sum.
+//-----------------------------------------------------------------------------
+double evaluator::compute_omega(e_metric m, timestamp anomaly_length,
+  position_moments const &positions) const
+{
+  position_sum length = anomaly_length;
+  position_sum count = positions.lower_count + positions.upper_count;
+  position_sum sum = positions.lower_sum + positions.upper_sum;
+  position_sum my_positional_bias, max_positional_bias;
+
+  TSAD_COUNT(c_omega_evaluations, 1);
+  switch ((m == e_precision) ? delta_p_ : delta_r_)
   {
-    ++overlap_count;
+    case e_flat:
+      my_positional_bias = count;
+      max_positional_bias = bias_sum<e_flat>(length, 1, length);
+      break;
+    case e_front:
+      my_positional_bias = (length + 1) * count - sum;
+      max_positional_bias = bias_sum<e_front>(length, 1, length);
+      break;
+    case e_middle:
+      my_positional_bias = positions.lower_sum + 
+                           (length + 1) * positions.upper_count - 
+                           positions.upper_sum;
+      max_positional_bias = bias_sum<e_middle>(length, 1, length);
+      break;
+    case e_back:
+      my_positional_bias = sum;
+      max_positional_bias = bias_sum<e_back>(length, 1, length);
+      break;
+    default:
+      throw "Error: Omega from moments needs a built-in positional bias!";
+  }
 
-    time_range overlap;
-    overlap.first = std::max(r1.first, r2.first);
-    overlap.second = std::min(r1.second, r2.second); 
+  if (max_positional_bias > 0)
+    return (double)my_positional_bias / (double)max_positional_bias;
+  else
+    return 0;
+}
 
-    return omega_function(r1, overlap, m); 
+//-----------------------------------------------------------------------------
+// Checks that each range is well-formed and starts after the previous one ends.
+//-----------------------------------------------------------------------------
+bool evaluator::is_sorted_disjoint(interval_span const &intervals)
+{
+  for (auto i = intervals.begin(); i != intervals.end(); ++i)
+  {
+    if (i->first > i->second) return false;
+    if ((i != intervals.begin()) && (i->first <= (i - 1)->second)) return false;
   }
+  return true;
 }
 
 //-----------------------------------------------------------------------------
-double evaluator::compute_precision() const
+// Omega and overlap count of a single range w.r.t. the ranges in
+// [first, last) of the other side. Non-overlapping ranges contribute nothing.
+//-----------------------------------------------------------------------------
+range_terms evaluator::overlap_terms(time_range range,
+  interval_span::const_iterator first, interval_span::const_iterator last,
+  e_metric m) const
 {
-  time_range range_p, range_r;
-  double existence_reward, omega_reward, overlap_reward;
-  int overlap_count;
-  double precision = 0.0;
+  range_terms terms;
+  terms.omega_reward = 0;
+  terms.overlap_count = 0;
 
-  if (predicted_anomalies_.size() == 0) return 0.0;
+  for (auto j = first; j != last; ++j) 
+  {
+    if ((range.second < j->first) || (range.first > j->second)) continue;
+
+    ++terms.overlap_count;
+    terms.omega_reward += omega_function(range,
+      time_range(std::max(range.first, j->first),
+                 std::min(range.second, j->second)), m);
+  }
+
+  TSAD_COUNT(c_range_pairs, last - first);
+  TSAD_COUNT(c_overlapping_pairs, terms.overlap_count);
+  return terms;
+}
+
+//-----------------------------------------------------------------------------
+template <positional_bias Delta>
+range_terms evaluator::overlap_terms(time_range range,
+  interval_span::const_iterator first, interval_span::const_iterator last,
+  e_metric m, udf_memo &memo) const
+{
+  range_terms terms;
+  terms.omega_reward = 0;
+  terms.overlap_count = 0;
+
+  delta_cache::prefix_sums const *prefix = NULL;
+  if ((Delta == e_udf_delta) && (first != last))
+    prefix = udf_prefix_sums(range.second - range.first + 1, m, memo);
 
-  for (auto i = predicted_anomalies_.begin();
-            i != predicted_anomalies_.end(); ++i) 
+  for (auto j = first; j != last; ++j) 
   {
-    range_p.first = i->first;
-    range_p.second = i->second;        
-    omega_reward = 0;
-    overlap_count = 0;
+    if ((range.second < j->first) || (range.first > j->second)) continue;
+
+    ++terms.overlap_count;
+    terms.omega_reward += omega_function<Delta>(range,
+      time_range(std::max(range.first, j->first),
+                 std::min(range.second, j->second)), m, prefix);
+  }
+
+  TSAD_COUNT(c_range_pairs, last - first);
+  TSAD_COUNT(c_overlapping_pairs, terms.overlap_count);
+  return terms;
+}
+
+//-----------------------------------------------------------------------------
+template <overlap_cardinality Gamma>
+double evaluator::range_reward(range_terms const &terms, e_metric m) const
+{
+  double existence_reward, overlap_reward;
+  double alpha = (m == e_precision) ? alpha_p_ : alpha_r_;
+
+  overlap_reward = gamma_policy<Gamma>(terms.overlap_count, m) * 
+                   terms.omega_reward;
+  existence_reward = (terms.overlap_count > 0) ? 1 : 0;
+  return alpha * existence_reward + (1.0 - alpha) * overlap_reward;
+}
+
+//-----------------------------------------------------------------------------
+double evaluator::range_reward(range_terms const &terms, e_metric m) const
+{
+  double existence_reward, overlap_reward;
+  double alpha = (m == e_precision) ? alpha_p_ : alpha_r_;
 
-    for (auto j = real_anomalies_.begin(); j != real_anomalies_.end(); ++j) 
+  overlap_reward = gamma_function(terms.overlap_count, m) * terms.omega_reward;
+  existence_reward = (terms.overlap_count > 0) ? 1 : 0;
+  return alpha * existence_reward + (1.0 - alpha) * overlap_reward;
+}
+
+//-----------------------------------------------------------------------------
+bool evaluator::use_sweep(interval_span const &outer,
+  interval_span const &inner) const
+{
+  return (engine_ == e_sweep) && 
+         is_sorted_disjoint(outer) && is_sorted_disjoint(inner);
+}
+
+//-----------------------------------------------------------------------------
+// Calls visit(i, first, last) for every outer range i in [begin, end), where
+// [first, last) holds the inner ranges that may overlap it. Callers decide
+// on the sweep with use_sweep(), once per pass rather than per shard.
+//
+// The sweep engine walks both sorted lists with two pointers. Since ranges
+// are disjoint, their end points increase monotonically, so every inner range
+// ending before the current outer range starts can never overlap a later one.
+// The inner ranges in [lo, hi) are then exactly those overlapping the current
+// outer range, which makes the cost O(P+R+overlaps). They are visited in the
+// same order as in the nested loop, hence results are bit-identical.
+//-----------------------------------------------------------------------------
+template <typename Visitor>
+void evaluator::for_each_overlapping(interval_span const &outer,
+  interval_span const &inner, size_t begin, size_t end, bool sweep,
+  Visitor visit) const
+{
+  if (!sweep)
+  {
+    for (size_t i = begin; i < end; ++i)
     {
-      range_r.first = j->first;
-      range_r.second = j->second;
+      visit(i, inner.begin(), inner.end());
+    }
+    return;
+  }
+
+  if (begin >= end) return;
+
+  // First inner range that does not end before outer[begin] starts.
+  auto lo = std::lower_bound(inner.begin(), inner.end(), outer[begin].first,
+    [](time_range const &r, timestamp t) { return r.second < t; });
+
+  for (size_t i = begin; i < end; ++i)
+  {
+    while ((lo != inner.end()) && (lo->second < outer[i].first)) ++lo;
+
+    auto hi = lo;
+    while ((hi != inner.end()) && (hi->first <= outer[i].second)) ++hi;
 
-      omega_reward += compute_omega_reward(range_p, range_r, overlap_count,
-                                           e_precision);
+    visit(i, lo, hi);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Sums reward(outer[i], first, last) over all outer ranges, where [first,
+// last) are the inner ranges that may overlap outer[i].
+//-----------------------------------------------------------------------------
+template <typename Reward>
+double evaluator::sum_rewards_with(interval_span const &outer,
+  interval_span const &inner, Reward reward) const
+{
+  double sum = 0.0;
+
+  bool sweep = use_sweep(outer, inner);
+  if ((threads_ > 1) && (outer.size() > shard_size) && sweep)
+    return sum_rewards_sharded(outer, inner, reward);
+
+  for_each_overlapping(outer, inner, 0, outer.size(), sweep,
+    [&](size_t i, interval_span::const_iterator first,
+        interval_span::const_iterator last)
+    {
+      sum += reward(outer[i], first, last);
+    });
+
+  return sum;
+}
+
+//-----------------------------------------------------------------------------
+// The gamma and delta of the metric are resolved once here rather than per
+// range and position, so that the per-range loop is a single instantiation
+// with both policies inlined. The reference engine and invalid values take
+// the generic path, which sums position by position and warns about invalid
+// values exactly as before.
+//-----------------------------------------------------------------------------
+double evaluator::sum_rewards(interval_span const &outer,
+  interval_span const &inner, e_metric m) const
+{
+  if (engine_ != e_nested)
+  {
+    switch ((m == e_precision) ? delta_p_ : delta_r_)
+    {
+      case e_flat:
+        return sum_rewards<e_flat>(outer, inner, m);
+      case e_front:
+        return sum_rewards<e_front>(outer, inner, m);
+      case e_middle:
+        return sum_rewards<e_middle>(outer, inner, m);
+      case e_back:
+        return sum_rewards<e_back>(outer, inner, m);
+      case e_udf_delta:
+        return sum_rewards<e_udf_delta>(outer, inner, m);
+      default:
+        break;
     }
+  }
+
+  return sum_rewards_with(outer, inner,
+    [this, m](time_range range, interval_span::const_iterator first,
+              interval_span::const_iterator last)
+    {
+      return range_reward(overlap_terms(range, first, last, m), m);
+    });
+}
 
-    overlap_reward = gamma_function(overlap_count, e_precision) * omega_reward;
-    existence_reward = (overlap_count > 0) ? 1 : 0;
-    precision += alpha_p_ * existence_reward + 
-                 (1.0 - alpha_p_) * overlap_reward;
+//-----------------------------------------------------------------------------
+template <positional_bias Delta>
+double evaluator::sum_rewards(interval_span const &outer,
+  interval_span const &inner, e_metric m) const
+{
+  switch ((m == e_precision) ? gamma_p_ : gamma_r_)
+  {
+    case e_one:
+      return sum_rewards<e_one, Delta>(outer, inner, m);
+    case e_reciprocal:
+      return sum_rewards<e_reciprocal, Delta>(outer, inner, m);
+    case e_udf_gamma:
+      return sum_rewards<e_udf_gamma, Delta>(outer, inner, m);
+    default:
+    {
+      udf_memo memo;
+      return sum_rewards_with(outer, inner,
+        [this, m, memo](time_range range, 
+          interval_span::const_iterator first,
+          interval_span::const_iterator last) mutable
+        {
+          return range_reward(overlap_terms<Delta>(range, first, last, m,
+                                                   memo), m);
+        });
+    }
   }
+}
 
-  return precision / predicted_anomalies_.size();
+//-----------------------------------------------------------------------------
+template <overlap_cardinality Gamma, positional_bias Delta>
+double evaluator::sum_rewards(interval_span const &outer,
+  interval_span const &inner, e_metric m) const
+{
+  udf_memo memo;
+  return sum_rewards_with(outer, inner,
+    [this, m, memo](time_range range, interval_span::const_iterator first,
+                    interval_span::const_iterator last) mutable
+    {
+      return range_reward<Gamma>(overlap_terms<Delta>(range, first, last, m,
+                                                      memo), m);
+    });
 }
 
 //-----------------------------------------------------------------------------
-double evaluator::compute_recall() const
+// Shards are consecutive blocks of outer ranges, i.e., time slices, of
+// ranges already known to suit the sweep engine. Each one
+// finds its own starting point in the inner ranges, so inner ranges that
+// straddle a shard boundary are seen by both shards. Workers compute the
+// per-range rewards of a shard, while this thread adds them up in range order
+// (exactly like the serial loop) and frees them. At most a few shards per
+// thread are in flight, which bounds memory.
+//-----------------------------------------------------------------------------
+template <typename Reward>
+double evaluator::sum_rewards_sharded(interval_span const &outer,
+  interval_span const &inner, Reward reward) const
 {
-  time_range range_p, range_r;
-  double existence_reward, omega_reward, overlap_reward;
-  int overlap_count;
-  double recall = 0.0;
+  size_t shards = (outer.size() + shard_size - 1) / shard_size;
+  size_t in_flight = 4 * threads_;
 
-  if (real_anomalies_.size() == 0) return 0.0;
+  std::vector<std::vector<double> > rewards(shards);
+  std::vector<char> done(shards, 0);
+  std::exception_ptr error;
+  std::mutex lock;
+  std::condition_variable finished;
 
-  for (auto i = real_anomalies_.begin(); i != real_anomalies_.end(); ++i) 
+  thread_pool pool(threads_);
+  size_t submitted = 0;
+  double sum = 0.0;
+
+  for (size_t s = 0; s < shards; ++s)
   {
-    range_r.first = i->first;
-    range_r.second = i->second;
-    omega_reward = 0;
-    overlap_count = 0;
+    for (; (submitted < shards) && (submitted < s + in_flight); ++submitted)
+    {
+      pool.submit([&, submitted]
+      {
+        size_t begin = submitted * shard_size;
+        size_t end = std::min(begin + shard_size, outer.size());
+        std::vector<double> shard_rewards;
+        shard_rewards.reserve(end - begin);
+        Reward shard_reward(reward); // Its state is private to this shard
+
+        std::exception_ptr shard_error;
+        try
+        {
+          for_each_overlapping(outer, inner, begin, end, true,
+            [&](size_t i, interval_span::const_iterator first,
+                interval_span::const_iterator last)
+            {
+              shard_rewards.push_back(shard_reward(outer[i], first, last));
+            });
+        }
+        catch (...)
+        {
+          shard_error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        rewards[submitted].swap(shard_rewards);
+        if (shard_error && !error) error = shard_error;
+        done[submitted] = 1;
+        finished.notify_all();
+      });
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    finished.wait(guard, [&] { return done[s] != 0; });
+    if (error) break;
 
-    for (auto j = predicted_anomalies_.begin();
-              j != predicted_anomalies_.end(); ++j) 
+    for (auto r = rewards[s].begin(); r != rewards[s].end(); ++r) sum += *r;
+    std::vector<double>().swap(rewards[s]);
+  }
+
+  pool.wait();
+  if (error) std::rethrow_exception(error);
+
+  return sum;
+}
+
+//-----------------------------------------------------------------------------
+void evaluator::compute_overlaps(e_metric m, overlap_table &table) const
+{
+  interval_span const &outer = (m == e_precision) ? predicted_anomalies_
+                                                   : real_anomalies_;
+  interval_span const &inner = (m == e_precision) ? real_anomalies_
+                                                   : predicted_anomalies_;
+
+  table.offsets.assign(1, 0);
+  table.overlaps.clear();
+
+  for_each_overlapping(outer, inner, 0, outer.size(), 
+    use_sweep(outer, inner),
+    [&](size_t i, interval_span::const_iterator first,
+        interval_span::const_iterator last)
     {
-      range_p.first = j->first;
-      range_p.second = j->second;
+      for (auto j = first; j != last; ++j)
+      {
+        if ((outer[i].second < j->first) || (outer[i].first > j->second))
+          continue;
+        table.overlaps.push_back(
+          time_range(std::max(outer[i].first, j->first),
+                     std::min(outer[i].second, j->second)));
+      }
+      TSAD_COUNT(c_range_pairs, last - first);
+      TSAD_COUNT(c_overlapping_pairs, 
+                 table.overlaps.size() - table.offsets.back());
+      table.offsets.push_back(table.overlaps.size());
+    });
+}
 
-      omega_reward += compute_omega_reward(range_r, range_p, overlap_count,
-                                           e_recall);
+//-----------------------------------------------------------------------------
+void evaluator::compute_terms(e_metric m, overlap_table const &table,
+  std::vector<range_terms> &terms) const
+{
+  interval_span const &outer = (m == e_precision) ? predicted_anomalies_
+                                                   : real_anomalies_;
+
+  if (table.offsets.size() != outer.size() + 1)
+    throw "Error: Overlap table does not match the anomaly ranges!";
+
+  terms.resize(outer.size());
+  for (size_t i = 0; i < outer.size(); ++i)
+  {
+    terms[i].omega_reward = 0;
+    terms[i].overlap_count = table.offsets[i + 1] - table.offsets[i];
+
+    for (size_t j = table.offsets[i]; j < table.offsets[i + 1]; ++j)
+    {
+      terms[i].omega_reward += omega_function(outer[i], table.overlaps[j], m);
     }
+  }
+}
 
-    overlap_reward = gamma_function(overlap_count, e_recall) * omega_reward;
-    existence_reward = (overlap_count > 0) ? 1 : 0;
-    recall += alpha_r_ * existence_reward + (1.0 - alpha_r_) * overlap_reward;
+//-----------------------------------------------------------------------------
+double evaluator::compute_range_reward(e_metric m, time_range range,
+  time_range const *overlaps, size_t n) const
+{
+  return compute_range_reward(m, range, overlaps, n, n);
+}
+
+//-----------------------------------------------------------------------------
+double evaluator::compute_range_reward(e_metric m, time_range range,
+  time_range const *overlaps, size_t n, timestamp overlap_count) const
+{
+  range_terms terms;
+  terms.omega_reward = 0;
+  terms.overlap_count = overlap_count;
+
+  for (size_t j = 0; j < n; ++j)
+  {
+    terms.omega_reward += omega_function(range, overlaps[j], m);
   }
 
-  return recall / real_anomalies_.size();
+  return range_reward(terms, m);
 }
 
+//-----------------------------------------------------------------------------
+double evaluator::compute_metric(e_metric m, 
+  std::vector<range_terms> const &terms) const
+{
+  double sum = 0.0;
+
+  if (terms.size() == 0) return 0.0;
+
+  for (auto i = terms.begin(); i != terms.end(); ++i)
+  {
+    sum += range_reward(*i, m);
+  }
+
+  return sum / terms.size();
+}
+
+//-----------------------------------------------------------------------------
+void evaluator::compute_rewards(e_metric m,
+  std::vector<range_terms> const &terms, std::vector<double> &rewards) const
+{
+  rewards.resize(terms.size());
+  for (size_t i = 0; i < terms.size(); ++i)
+  {
+    rewards[i] = range_reward(terms[i], m);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Same arithmetic as range_reward(), so rewards are bit-identical.
+//-----------------------------------------------------------------------------
+range_contribution evaluator::compute_contribution(e_metric m,
+  range_terms const &terms) const
+{
+  range_contribution contribution;
+  double overlap_reward;
+  double alpha = (m == e_precision) ? alpha_p_ : alpha_r_;
+
+  contribution.gamma = gamma_function(terms.overlap_count, m);
+  overlap_reward = contribution.gamma * terms.omega_reward;
+  contribution.existence_reward = (terms.overlap_count > 0) ? 1 : 0;
+  contribution.reward = alpha * contribution.existence_reward + 
+                        (1.0 - alpha) * overlap_reward;
+  return contribution;
+}
+
+//-----------------------------------------------------------------------------
+double evaluator::compute_precision() const
+{
+  if (predicted_anomalies_.size() == 0) return 0.0;
+
+  return sum_rewards(predicted_anomalies_, real_anomalies_, e_precision) /
+         predicted_anomalies_.size();
+}
+
+//-----------------------------------------------------------------------------
+double evaluator::compute_recall() const
+{
+  if (real_anomalies_.size() == 0) return 0.0;
+
+  return sum_rewards(real_anomalies_, predicted_anomalies_, e_recall) /
+         real_anomalies_.size();
+}
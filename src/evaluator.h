@@ -27,10 +27,15 @@ SOFTWARE.
 #ifndef EVALUATOR_H_
 #define EVALUATOR_H_
 
+#include <algorithm>
 #include <cmath>
 #include <string>
 #include <vector>
 #include <iostream>
+#include <memory>
+
+#include "delta_cache.h"
+#include "udf_plugin.h"
 
 //-----------------------------------------------------------------------------
 // All header code goes within the anomaly namespace to avoid naming collisions
@@ -38,12 +43,113 @@ SOFTWARE.
 namespace anomaly
 {
 
-typedef int timestamp; // Starts from 0 and represents label position in input.
+typedef long long timestamp; // Label position in input, starting from 0.
 typedef std::pair<timestamp, timestamp> time_range;
 typedef std::vector<time_range> time_intervals;
 typedef enum {e_one, e_reciprocal, e_udf_gamma} overlap_cardinality;
 typedef enum {e_flat, e_front, e_middle, e_back, e_udf_delta} positional_bias;
 typedef enum {e_precision, e_recall, e_fscore} e_metric;
+typedef enum {e_sweep, e_nested} pairing_engine;
+
+//-----------------------------------------------------------------------------
+// Non-owning view of anomaly ranges held by the caller, e.g. a time_intervals
+// or a buffer of (start, end) pairs. The ranges must outlive the view.
+//-----------------------------------------------------------------------------
+class interval_span
+{
+public:
+
+  typedef time_range const * const_iterator;
+
+  interval_span() : data_(NULL), size_(0) {}
+  interval_span(time_range const *data, size_t size)
+  : data_(data), size_(size)
+  {}
+  explicit interval_span(time_intervals const &intervals)
+  : data_(intervals.data()), size_(intervals.size())
+  {}
+
+  const_iterator begin() const { return data_; }
+  const_iterator end() const { return data_ + size_; }
+  time_range const & operator[](size_t i) const { return data_[i]; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+private:
+
+  time_range const *data_;
+  size_t size_;
+};
+
+//-----------------------------------------------------------------------------
+// Overlaps of every range on one side (predicted ranges for precision, real
+// ranges for recall) with the ranges on the other side. The overlaps of
+// range i are overlaps[offsets[i]] .. overlaps[offsets[i+1]-1], ascending.
+//-----------------------------------------------------------------------------
+struct overlap_table
+{
+  std::vector<size_t> offsets;
+  time_intervals overlaps;
+};
+
+//-----------------------------------------------------------------------------
+// The parts of a range's reward that depend neither on gamma nor on alpha.
+//-----------------------------------------------------------------------------
+struct range_terms
+{
+  timestamp overlap_count;
+  double omega_reward; // Sum of omega over all overlaps of the range
+};
+
+//-----------------------------------------------------------------------------
+// Sums of positions reach about L^2/2 for ranges of length L, beyond 64 bits
+// once ranges are longer than about 4e9 labels.
+//-----------------------------------------------------------------------------
+typedef __int128 position_sum;
+
+// Sum of t over positions t in [a .. b] (empty if b < a).
+inline position_sum series_sum(position_sum a, position_sum b)
+{
+  if (b < a) return 0;
+  return (a + b) * (b - a + 1) / 2;
+}
+
+//-----------------------------------------------------------------------------
+// Number and sum of the positions t (1-based in a range of length L) that
+// lie in any overlap of the range, split into t <= L/2 (lower) and t > L/2
+// (upper). Omega with a built-in positional bias follows from these alone.
+//-----------------------------------------------------------------------------
+struct position_moments
+{
+  position_sum lower_count;
+  position_sum lower_sum;
+  position_sum upper_count;
+  position_sum upper_sum;
+};
+
+//-----------------------------------------------------------------------------
+// How a range's reward comes about: reward = alpha * existence_reward +
+// (1 - alpha) * gamma * omega_reward.
+//-----------------------------------------------------------------------------
+struct range_contribution
+{
+  double existence_reward;
+  double gamma; // Overlap cardinality factor
+  double reward;
+};
+
+//-----------------------------------------------------------------------------
+// User-defined functions loaded from a plugin (see udf_plugin.h). NULL
+// members select the compiled-in udf_gamma_def() and udf_delta_def().
+//-----------------------------------------------------------------------------
+struct udf_functions
+{
+  udf_functions() : gamma(NULL), delta_p(NULL), delta_r(NULL) {}
+
+  tsad_udf_gamma gamma;
+  tsad_udf_delta delta_p;
+  tsad_udf_delta delta_r;
+};
 
 class evaluator
 {
@@ -54,20 +160,47 @@ public:
   //---------------------------------------------------------------------------
   evaluator()
   : beta_(1), alpha_p_(0), alpha_r_(0), gamma_p_(e_one), gamma_r_(e_one),
-    delta_p_(e_flat), delta_r_(e_flat), precision_(0), recall_(0), fscore_(0)
+    delta_p_(e_flat), delta_r_(e_flat), engine_(e_sweep), threads_(1),
+    precision_(0), recall_(0), fscore_(0)
   {}
 
   evaluator(time_intervals const &real, time_intervals const &predicted)
   : beta_(1), alpha_p_(0), alpha_r_(0), gamma_p_(e_one), gamma_r_(e_one),
-    delta_p_(e_flat), delta_r_(e_flat), precision_(0), recall_(0), fscore_(0),
+    delta_p_(e_flat), delta_r_(e_flat), engine_(e_sweep), threads_(1),
+    precision_(0), recall_(0), fscore_(0)
+  {
+    own_anomalies(real, predicted);
+  }
+
+  evaluator(time_intervals const &real, time_intervals const &predicted, 
+    double const beta, double const alpha_r, overlap_cardinality const &gamma, 
+    positional_bias const &delta_p, positional_bias const &delta_r)
+  : beta_(beta), alpha_p_(0), alpha_r_(alpha_r), gamma_p_(gamma),
+    gamma_r_(gamma), delta_p_(delta_p), delta_r_(delta_r), engine_(e_sweep),
+    threads_(1),
+    precision_(0), recall_(0), fscore_(0)
+  {
+    own_anomalies(real, predicted);
+  }
+
+  //---------------------------------------------------------------------------
+  // Zero-copy constructors: the evaluator only refers to the caller's ranges,
+  // which must stay unchanged while it is in use. Copies of an evaluator
+  // refer to the same ranges (or share the ones it owns).
+  //---------------------------------------------------------------------------
+  evaluator(interval_span real, interval_span predicted)
+  : beta_(1), alpha_p_(0), alpha_r_(0), gamma_p_(e_one), gamma_r_(e_one),
+    delta_p_(e_flat), delta_r_(e_flat), engine_(e_sweep), threads_(1),
+    precision_(0), recall_(0), fscore_(0),
     real_anomalies_(real), predicted_anomalies_(predicted)
   {}
 
-  evaluator(time_intervals const &real, time_intervals const &predicted, 
+  evaluator(interval_span real, interval_span predicted, 
     double const beta, double const alpha_r, overlap_cardinality const &gamma, 
     positional_bias const &delta_p, positional_bias const &delta_r)
   : beta_(beta), alpha_p_(0), alpha_r_(alpha_r), gamma_p_(gamma),
-    gamma_r_(gamma), delta_p_(delta_p), delta_r_(delta_r),
+    gamma_r_(gamma), delta_p_(delta_p), delta_r_(delta_r), engine_(e_sweep),
+    threads_(1),
     precision_(0), recall_(0), fscore_(0),
     real_anomalies_(real), predicted_anomalies_(predicted)
   {}
@@ -85,6 +218,16 @@ public:
   overlap_cardinality const & get_gamma_r() { return gamma_r_; }
   positional_bias const & get_delta_p() const { return delta_p_; }
   positional_bias const & get_delta_r() const { return delta_r_; }
+  udf_functions const & get_udfs() const { return udfs_; }
+  interval_span const & get_real_anomalies() const { return real_anomalies_; }
+  interval_span const & get_predicted_anomalies() const
+    { return predicted_anomalies_; }
+  pairing_engine const & get_engine() const { return engine_; }
+  unsigned const & get_threads() const { return threads_; }
+  unsigned long long get_udf_cache_hits() const
+    { return udf_cache_.get_hits(); }
+  unsigned long long get_udf_cache_misses() const
+    { return udf_cache_.get_misses(); }
   double const & get_precision() const { return precision_; }
   double const & get_recall() const { return recall_; }
   double const & get_fscore() const { return fscore_; }
@@ -101,13 +244,65 @@ public:
   //---------------------------------------------------------------------------
   double compute_precision() const;
   double compute_recall() const;
-  double compute_fscore() const
+  double compute_fscore() const { return compute_fscore(precision_, recall_); }
+  double compute_fscore(double precision, double recall) const
   {
     double beta_sqr = pow(beta_, 2.0);
-    return (1 + beta_sqr) * (precision_ * recall_) /
-           (beta_sqr * precision_ + recall_); 
+    return (1 + beta_sqr) * (precision * recall) /
+           (beta_sqr * precision + recall); 
   }
 
+  //---------------------------------------------------------------------------
+  // Staged computation for evaluating many parameter settings on the same
+  // ranges: overlaps depend on the ranges only, terms also on the positional
+  // bias of the metric, and the metric itself on gamma and alpha as well.
+  // compute_metric(m, terms) equals compute_precision()/compute_recall().
+  //---------------------------------------------------------------------------
+  void compute_overlaps(e_metric m, overlap_table &table) const;
+  void compute_terms(e_metric m, overlap_table const &table,
+    std::vector<range_terms> &terms) const;
+  double compute_metric(e_metric m, std::vector<range_terms> const &terms) 
+    const;
+
+  // Per-range rewards, whose mean is compute_metric(m, terms).
+  void compute_rewards(e_metric m, std::vector<range_terms> const &terms,
+    std::vector<double> &rewards) const;
+  range_contribution compute_contribution(e_metric m, 
+    range_terms const &terms) const;
+
+  // True if ranges are sorted and disjoint, as required by the sweep engine.
+  static bool is_sorted_disjoint(interval_span const &intervals);
+
+  //---------------------------------------------------------------------------
+  // Reward of a single range (a predicted range for precision, a real range
+  // for recall) given its n overlaps with the ranges of the other side, in
+  // ascending order. Metrics are the mean reward over all ranges.
+  //---------------------------------------------------------------------------
+  double compute_range_reward(e_metric m, time_range range,
+    time_range const *overlaps, size_t n) const;
+
+  // Same, where the n overlaps stand for overlap_count overlaps in all, as
+  // when adjacent unit-size overlaps are merged into ranges (omega adds up
+  // over positions).
+  double compute_range_reward(e_metric m, time_range range,
+    time_range const *overlaps, size_t n, timestamp overlap_count) const;
+
+  // Omega of one overlap of a range, the part of compute_range_reward() that
+  // adds up over overlaps and over the positions of an overlap. O(1) for the
+  // built-in biases.
+  double compute_omega(e_metric m, time_range range, time_range overlap)
+    const
+  {
+    return omega_function(range, overlap, m);
+  }
+
+  // Omega of all overlaps of a range at once, from the moments of their
+  // positions, for a built-in positional bias only. Rounds once rather than
+  // once per overlap, so it may differ in the last digit.
+  bool has_builtin_bias(e_metric m) const;
+  double compute_omega(e_metric m, timestamp anomaly_length,
+    position_moments const &positions) const;
+
   //---------------------------------------------------------------------------
   // Setters
   //---------------------------------------------------------------------------
@@ -154,24 +349,131 @@ public:
     delta_r_ = bias;
   }
 
+  //---------------------------------------------------------------------------
+  // Plugin functions used for udf_gamma and udf_delta.
+  //---------------------------------------------------------------------------
+  void set_udfs(udf_functions const &udfs)
+  {
+    udfs_ = udfs;
+    udf_cache_.clear(); // Cached prefix sums are those of the old functions
+  }
+
+  //---------------------------------------------------------------------------
+  // e_sweep (default) visits only overlapping range pairs and requires both
+  // interval lists to be sorted and disjoint (as produced by read_file); it
+  // silently visits all pairs otherwise. e_nested is the reference all-pairs
+  // loop that sums positional biases position by position, as the original
+  // code did. Results are bit-for-bit identical while the sums of positions
+  // stay below 2^53, i.e. for ranges shorter than about 1e8 labels.
+  //---------------------------------------------------------------------------
+  void set_engine(pairing_engine const &engine)
+  {
+    if ((engine != e_sweep) && (engine != e_nested))
+      throw "Error: Invalid pairing engine value!";
+    engine_ = engine;
+  }
+
+  //---------------------------------------------------------------------------
+  // With more than one thread, the sweep engine splits the ranges into time
+  // shards that are evaluated concurrently. Per-range rewards are still
+  // summed in range order, so results do not depend on the thread count.
+  //---------------------------------------------------------------------------
+  void set_threads(unsigned threads)
+  {
+    if (threads < 1) throw "Error: Invalid number of threads!";
+    threads_ = threads;
+  }
+
+  //---------------------------------------------------------------------------
+  // Bounds the memory (in cached values) used for udf_delta prefix sums.
+  // Ranges longer than the capacity are evaluated without the cache.
+  //---------------------------------------------------------------------------
+  void set_udf_cache_capacity(size_t capacity)
+  {
+    udf_cache_.set_capacity(capacity);
+  }
+
 private:
 
+  //---------------------------------------------------------------------------
+  // Direct-mapped front end to udf_cache_ for one metric, owned by a single
+  // thread during one pass, so that most ranges find their udf_delta prefix
+  // sums without taking the shared cache's lock. Slots do not keep entries
+  // alive once udf_cache_ evicts them; only the entry in use is held. Ranges
+  // too long to be cached get their prefix sums in a buffer reused across
+  // ranges.
+  //---------------------------------------------------------------------------
+  struct udf_memo
+  {
+    static const size_t slots = 1024;
+
+    udf_memo() { std::fill(lengths, lengths + slots, 0); }
+
+    timestamp lengths[slots];
+    std::weak_ptr<delta_cache::prefix_sums const> sums[slots];
+    delta_cache::prefix_sums_ptr current;
+    delta_cache::prefix_sums uncached;
+  };
+
+  void own_anomalies(time_intervals const &real,
+    time_intervals const &predicted);
+
+  // Sum of per-range rewards of outer ranges against inner ranges
+  double sum_rewards(interval_span const &outer, interval_span const &inner,
+    e_metric m) const;
+  template <positional_bias Delta>
+  double sum_rewards(interval_span const &outer, interval_span const &inner,
+    e_metric m) const;
+  template <overlap_cardinality Gamma, positional_bias Delta>
+  double sum_rewards(interval_span const &outer, interval_span const &inner,
+    e_metric m) const;
+  template <typename Reward>
+  double sum_rewards_with(interval_span const &outer,
+    interval_span const &inner, Reward reward) const;
+  template <typename Reward>
+  double sum_rewards_sharded(interval_span const &outer,
+    interval_span const &inner, Reward reward) const;
+  range_terms overlap_terms(time_range range, 
+    interval_span::const_iterator first, interval_span::const_iterator last,
+    e_metric m) const;
+  template <positional_bias Delta>
+  range_terms overlap_terms(time_range range, 
+    interval_span::const_iterator first, interval_span::const_iterator last,
+    e_metric m, udf_memo &memo) const;
+  double range_reward(range_terms const &terms, e_metric m) const;
+  template <overlap_cardinality Gamma>
+  double range_reward(range_terms const &terms, e_metric m) const;
+  template <typename Visitor>
+  void for_each_overlapping(interval_span const &outer,
+    interval_span const &inner, size_t begin, size_t end, bool sweep,
+    Visitor visit) const;
+  bool use_sweep(interval_span const &outer, interval_span const &inner)
+    const;
+
   // Fixed function for omega
-  double compute_omega_reward(time_range r1, time_range r2, 
-    int& overlap_count, e_metric m) const;
   double omega_function(time_range range, time_range overlap, e_metric m) const;
+  template <positional_bias Delta>
+  double omega_function(time_range range, time_range overlap, e_metric m,
+    delta_cache::prefix_sums const *prefix) const;
 
   // Optional user-defined function (udf) for gamma
-  double udf_gamma_def(int overlap_count, e_metric m) const;
-  double gamma_function(int overlap_count, e_metric m) const;
-  double gamma_select(overlap_cardinality const &gamma, int overlap,
-    e_metric m, std::string const &prec_or_recall) const;
+  double udf_gamma_def(timestamp overlap_count, e_metric m) const;
+  double gamma_function(timestamp overlap_count, e_metric m) const;
+  double gamma_select(overlap_cardinality const &gamma, timestamp overlap,
+    e_metric m) const;
+  template <overlap_cardinality Gamma>
+  double gamma_policy(timestamp overlap, e_metric m) const;
+  double udf_gamma(timestamp overlap, e_metric m) const;
 
   // Optional user-defined function (udf) for delta
   double udf_delta_def(timestamp, timestamp, e_metric) const;
   double delta_function(timestamp, timestamp, e_metric) const;
   double delta_select(positional_bias const &, timestamp, timestamp, 
-    e_metric, std::string const &) const;
+    e_metric) const;
+  void udf_delta(timestamp, e_metric, double *) const;
+  delta_cache::prefix_sums_ptr udf_prefix_sums(timestamp, e_metric) const;
+  delta_cache::prefix_sums const * udf_prefix_sums(timestamp, e_metric,
+    udf_memo &) const;
 
   //---------------------------------------------------------------------------
   // Members
@@ -187,12 +489,23 @@ private:
   positional_bias delta_p_; // Customizable positional bias
   positional_bias delta_r_; // Customizable positional bias
 
+  udf_functions udfs_; // Plugin functions for udf_gamma and udf_delta
+
+  pairing_engine engine_; // How overlapping range pairs are enumerated
+  unsigned threads_; // Threads used by the sweep engine
+
   double precision_;
   double recall_;
   double fscore_;
 
-  time_intervals real_anomalies_;
-  time_intervals predicted_anomalies_;
+  mutable delta_cache udf_cache_; // Shared by precision and recall
+
+  // Ranges copied by the owning constructors, NULL for spans
+  std::shared_ptr<time_intervals const> owned_real_;
+  std::shared_ptr<time_intervals const> owned_predicted_;
+
+  interval_span real_anomalies_;
+  interval_span predicted_anomalies_;
 };
 
 }
@@ -0,0 +1,156 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+
+#include "interval_file.h"
+#include "synthetic.h"
+
+using namespace std;
+using namespace anomaly;
+
+//----------------------------------------------------------------------------
+void output_usage(char *argv[])
+{
+  workload w;
+
+  cout << endl;
+  cout << "Usage: " << endl;
+  cout << argv[0] 
+       << " {-n <length>} {-d <density>} {-l <mean_length>}"
+       << " {-s fixed | uniform | geometric} {-j <jitter>} {-m <miss_rate>}"
+       << " {-f <false_rate>} {-x <seed>} {-o labels | ranges}"
+       << " <real_data_file> <predicted_data_file>"
+       << endl;
+  cout << "    -n        : " 
+       << "Series length in labels, Default = " << w.length
+       << endl;
+  cout << "    -d        : " 
+       << "Expected fraction of anomalous real labels, Default = " << w.density
+       << endl;
+  cout << "    -l        : " 
+       << "Mean length of anomaly ranges, Default = " << w.mean_range_length
+       << endl;
+  cout << "    -s        : " 
+       << "Distribution of range lengths, Default = geometric"
+       << endl;
+  cout << "    -j        : " 
+       << "Maximum shift of predicted range boundaries, Default = " << w.jitter
+       << endl;
+  cout << "    -m        : " 
+       << "Fraction of real ranges left unpredicted, Default = " << w.miss_rate
+       << endl;
+  cout << "    -f        : " 
+       << "False positive ranges per real range, Default = " << w.false_rate
+       << endl;
+  cout << "    -x        : " 
+       << "Random seed, Default = " << w.seed
+       << endl;
+  cout << "    -o        : " 
+       << "Write 0/1 label files or range lists, Default = labels"
+       << endl;
+  cout << endl;
+}
+
+//----------------------------------------------------------------------------
+// Writes a synthetic pair of real and predicted label files.
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  workload w;
+  bool ranges = false;
+
+  int offset = 0;
+  while ((2+offset < argc) && (argv[1+offset][0] == '-'))
+  {
+    string option = argv[1+offset];
+    char const *value = argv[2+offset];
+
+    if (option == "-n") w.length = atoll(value);
+    else if (option == "-d") w.density = atof(value);
+    else if (option == "-l") w.mean_range_length = atof(value);
+    else if (option == "-j") w.jitter = atoi(value);
+    else if (option == "-m") w.miss_rate = atof(value);
+    else if (option == "-f") w.false_rate = atof(value);
+    else if (option == "-x") w.seed = (unsigned)atol(value);
+    else if (option == "-s")
+    {
+      string lengths = value;
+      if (lengths == "fixed") w.lengths = e_fixed_length;
+      else if (lengths == "uniform") w.lengths = e_uniform_length;
+      else if (lengths == "geometric") w.lengths = e_geometric_length;
+      else
+      {
+        cerr << "Error: Invalid range length distribution!" << endl;
+        return 1;
+      }
+    }
+    else if (option == "-o")
+    {
+      string format = value;
+      if (format == "labels") ranges = false;
+      else if (format == "ranges") ranges = true;
+      else
+      {
+        cerr << "Error: Invalid output format!" << endl;
+        return 1;
+      }
+    }
+    else break;
+    offset += 2;
+  }
+
+  if (argc - offset != 3)
+  {
+    output_usage(argv);
+    return 1;
+  }
+
+  try
+  {
+    time_intervals real, predicted;
+    generate_workload(w, real, predicted);
+    if (ranges)
+    {
+      write_range_list(argv[1+offset], real, w.length);
+      write_range_list(argv[2+offset], predicted, w.length);
+    }
+    else
+    {
+      write_label_file(argv[1+offset], real, w.length);
+      write_label_file(argv[2+offset], predicted, w.length);
+    }
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#include "grid.h"
+
+#include <map>
+
+using namespace anomaly;
+
+//-----------------------------------------------------------------------------
+char const * anomaly::cardinality_name(overlap_cardinality gamma)
+{
+  switch (gamma)
+  {
+    case e_one: return "one";
+    case e_reciprocal: return "reciprocal";
+    case e_udf_gamma: return "udf_gamma";
+    default: return "invalid";
+  }
+}
+
+//-----------------------------------------------------------------------------
+char const * anomaly::bias_name(positional_bias delta)
+{
+  switch (delta)
+  {
+    case e_flat: return "flat";
+    case e_front: return "front";
+    case e_middle: return "middle";
+    case e_back: return "back";
+    case e_udf_delta: return "udf_delta";
+    default: return "invalid";
+  }
+}
+
+//-----------------------------------------------------------------------------
+std::vector<grid_result> anomaly::evaluate_grid(evaluator &e,
+  parameter_grid const &grid)
+{
+  overlap_table overlaps_p, overlaps_r;
+  e.compute_overlaps(e_precision, overlaps_p);
+  e.compute_overlaps(e_recall, overlaps_r);
+
+  // Range terms only depend on the positional bias of each metric.
+  std::map<positional_bias, std::vector<range_terms> > terms_p, terms_r;
+  for (auto d = grid.delta_ps.begin(); d != grid.delta_ps.end(); ++d)
+  {
+    if (terms_p.count(*d)) continue;
+    e.set_delta_p(*d);
+    e.compute_terms(e_precision, overlaps_p, terms_p[*d]);
+  }
+  for (auto d = grid.delta_rs.begin(); d != grid.delta_rs.end(); ++d)
+  {
+    if (terms_r.count(*d)) continue;
+    e.set_delta_r(*d);
+    e.compute_terms(e_recall, overlaps_r, terms_r[*d]);
+  }
+
+  std::vector<grid_result> results;
+  grid_result r;
+
+  for (auto b = grid.betas.begin(); b != grid.betas.end(); ++b)
+  for (auto a = grid.alpha_rs.begin(); a != grid.alpha_rs.end(); ++a)
+  for (auto g = grid.gammas.begin(); g != grid.gammas.end(); ++g)
+  for (auto dp = grid.delta_ps.begin(); dp != grid.delta_ps.end(); ++dp)
+  for (auto dr = grid.delta_rs.begin(); dr != grid.delta_rs.end(); ++dr)
+  {
+    e.set_beta(*b);
+    e.set_alpha_r(*a);
+    e.set_gamma(*g);
+
+    r.beta = *b;
+    r.alpha_r = *a;
+    r.gamma = *g;
+    r.delta_p = *dp;
+    r.delta_r = *dr;
+    r.precision = e.compute_metric(e_precision, terms_p[*dp]);
+    r.recall = e.compute_metric(e_recall, terms_r[*dr]);
+    r.fscore = e.compute_fscore(r.precision, r.recall);
+    results.push_back(r);
+  }
+
+  return results;
+}
+
+//-----------------------------------------------------------------------------
+void anomaly::write_grid_csv(std::ostream &out,
+  std::vector<grid_result> const &results)
+{
+  out << "beta,alpha_r,gamma,delta_p,delta_r,precision,recall,fscore\n";
+  for (auto r = results.begin(); r != results.end(); ++r)
+  {
+    out << r->beta << "," << r->alpha_r << "," << cardinality_name(r->gamma)
+        << "," << bias_name(r->delta_p) << "," << bias_name(r->delta_r) << ","
+        << r->precision << "," << r->recall << "," << r->fscore << "\n";
+  }
+  out.flush();
+}
+
+//-----------------------------------------------------------------------------
+// JSON has no NaN (e.g., the F-Score when precision = recall = 0).
+//-----------------------------------------------------------------------------
+static void write_json_number(std::ostream &out, double value)
+{
+  if (std::isfinite(value)) out << value;
+  else out << "null";
+}
+
+//-----------------------------------------------------------------------------
+void anomaly::write_grid_json(std::ostream &out,
+  std::vector<grid_result> const &results)
+{
+  out << "[\n";
+  for (auto r = results.begin(); r != results.end(); ++r)
+  {
+    out << "  {\"beta\": " << r->beta << ", \"alpha_r\": " << r->alpha_r
+        << ", \"gamma\": \"" << cardinality_name(r->gamma)
+        << "\", \"delta_p\": \"" << bias_name(r->delta_p)
+        << "\", \"delta_r\": \"" << bias_name(r->delta_r)
+        << "\", \"precision\": ";
+    write_json_number(out, r->precision);
+    out << ", \"recall\": ";
+    write_json_number(out, r->recall);
+    out << ", \"fscore\": ";
+    write_json_number(out, r->fscore);
+    out << ((r + 1 != results.end()) ? "},\n" : "}\n");
+  }
+  out << "]\n";
+  out.flush();
+}
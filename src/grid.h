@@ -0,0 +1,80 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#ifndef GRID_H_
+#define GRID_H_
+
+#include <ostream>
+#include <vector>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Lists of parameter values; the grid is their cartesian product.
+//-----------------------------------------------------------------------------
+struct parameter_grid
+{
+  std::vector<double> betas;
+  std::vector<double> alpha_rs;
+  std::vector<overlap_cardinality> gammas;
+  std::vector<positional_bias> delta_ps;
+  std::vector<positional_bias> delta_rs;
+};
+
+struct grid_result
+{
+  double beta;
+  double alpha_r;
+  overlap_cardinality gamma;
+  positional_bias delta_p;
+  positional_bias delta_r;
+  double precision;
+  double recall;
+  double fscore;
+};
+
+//-----------------------------------------------------------------------------
+// Evaluates every parameter combination of the grid on the ranges held by
+// the evaluator (whose parameters are changed along the way). Overlapping
+// range pairs are enumerated once, omega is computed once per positional
+// bias, and results are identical to evaluating each combination on its own.
+// Results are ordered by beta, alpha_r, gamma, delta_p, then delta_r.
+//-----------------------------------------------------------------------------
+std::vector<grid_result> evaluate_grid(evaluator &e,
+  parameter_grid const &grid);
+
+void write_grid_csv(std::ostream &out, std::vector<grid_result> const &results);
+void write_grid_json(std::ostream &out, 
+  std::vector<grid_result> const &results);
+
+char const * cardinality_name(overlap_cardinality gamma);
+char const * bias_name(positional_bias delta);
+
+}
+
+#endif // GRID_H_
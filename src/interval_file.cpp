@@ -0,0 +1,283 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#include "interval_file.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace anomaly;
+
+typedef unsigned long long u64;
+
+//-----------------------------------------------------------------------------
+static u64 get_le(char const *data, int bytes)
+{
+  u64 value = 0;
+  for (int i = bytes - 1; i >= 0; --i)
+    value = (value << 8) | (unsigned char)data[i];
+  return value;
+}
+
+//-----------------------------------------------------------------------------
+static void put_le(std::vector<char> &out, u64 value, int bytes)
+{
+  for (int i = 0; i < bytes; ++i, value >>= 8) out.push_back((char)value);
+}
+
+//-----------------------------------------------------------------------------
+static u64 get_varint(char const *&data, char const *end)
+{
+  u64 value = 0;
+  for (int shift = 0; shift < 64; shift += 7)
+  {
+    if (data == end) throw "Error: Corrupt interval file!";
+    unsigned char byte = *data++;
+    value |= (u64)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return value;
+  }
+  throw "Error: Corrupt interval file!";
+}
+
+//-----------------------------------------------------------------------------
+static void put_varint(std::vector<char> &out, u64 value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back((char)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((char)value);
+}
+
+//-----------------------------------------------------------------------------
+bool anomaly::is_interval_file(char const *data, size_t size)
+{
+  return (size >= sizeof(interval_file_magic)) &&
+         (memcmp(data, interval_file_magic, sizeof(interval_file_magic)) == 0);
+}
+
+//-----------------------------------------------------------------------------
+time_intervals anomaly::decode_interval_file(char const *data, size_t size,
+  bool unitsize, timestamp &count)
+{
+  if ((size < interval_file_header_size) || !is_interval_file(data, size))
+    throw "Error: Corrupt interval file!";
+  if (get_le(data + 4, 4) != interval_file_version)
+    throw "Error: Unsupported interval file version!";
+
+  bool compact = (get_le(data + 8, 4) & interval_file_compact) != 0;
+  u64 length = get_le(data + 16, 8);
+  u64 n = get_le(data + 24, 8);
+  char const *pos = data + interval_file_header_size;
+  char const *end = data + size;
+
+  if (length > (u64)LLONG_MAX) throw "Error: Series too long!";
+  if (!compact && ((u64)(end - pos) / 16 < n))
+    throw "Error: Corrupt interval file!";
+  if (compact && ((u64)(end - pos) / 2 < n))
+    throw "Error: Corrupt interval file!";
+
+  time_intervals anomalies;
+  if (!unitsize) anomalies.reserve(n);
+
+  u64 previous_end = 0;
+  for (u64 i = 0; i < n; ++i)
+  {
+    u64 first, second;
+    if (compact)
+    {
+      first = get_varint(pos, end) + ((i > 0) ? previous_end + 1 : 0);
+      second = first + get_varint(pos, end);
+    }
+    else
+    {
+      first = get_le(pos, 8);
+      second = get_le(pos + 8, 8);
+      pos += 16;
+    }
+
+    if ((first > second) || (second >= length) || 
+        ((i > 0) && (first <= previous_end)))
+      throw "Error: Corrupt interval file!";
+
+    if (unitsize)
+    {
+      for (u64 t = first; t <= second; ++t)
+        anomalies.push_back(time_range(t, t));
+    }
+    else if ((i > 0) && (first == previous_end + 1))
+      anomalies.back().second = second;
+    else anomalies.push_back(time_range(first, second));
+    previous_end = second;
+  }
+
+  count = (timestamp)length;
+  return anomalies;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<char> anomaly::encode_interval_file(
+  time_intervals const &anomalies, timestamp count, bool compact)
+{
+  std::vector<char> out(interval_file_magic, 
+                        interval_file_magic + sizeof(interval_file_magic));
+  out.reserve(interval_file_header_size + 16 * anomalies.size());
+  put_le(out, interval_file_version, 4);
+  put_le(out, compact ? interval_file_compact : 0, 4);
+  put_le(out, 0, 4);
+  put_le(out, count, 8);
+  put_le(out, anomalies.size(), 8);
+
+  for (auto i = anomalies.begin(); i != anomalies.end(); ++i)
+  {
+    if (compact)
+    {
+      u64 gap = (i == anomalies.begin()) ? i->first
+                                         : i->first - (i - 1)->second - 1;
+      put_varint(out, gap);
+      put_varint(out, i->second - i->first);
+    }
+    else
+    {
+      put_le(out, i->first, 8);
+      put_le(out, i->second, 8);
+    }
+  }
+  return out;
+}
+
+//-----------------------------------------------------------------------------
+void anomaly::write_interval_file(std::string const &path,
+  time_intervals const &anomalies, timestamp count, bool compact)
+{
+  std::vector<char> out = encode_interval_file(anomalies, count, compact);
+
+  FILE *file = fopen(path.c_str(), "wb");
+  if (file == NULL) throw "Error: Could not open file!";
+  bool ok = (fwrite(&out[0], 1, out.size(), file) == out.size());
+  ok = (fclose(file) == 0) && ok;
+  if (!ok) throw "Error: Could not write file!";
+}
+
+//-----------------------------------------------------------------------------
+bool anomaly::is_range_list(char const *data, size_t size)
+{
+  return (size > 0) && (data[0] == '#');
+}
+
+//-----------------------------------------------------------------------------
+// Parses a nonnegative decimal number at data, skipping spaces and tabs
+// around it.
+//-----------------------------------------------------------------------------
+static u64 get_number(char const *&data, char const *end)
+{
+  while ((data < end) && ((*data == ' ') || (*data == '\t'))) ++data;
+  if ((data == end) || (*data < '0') || (*data > '9'))
+    throw "Error: Invalid range list!";
+
+  u64 value = 0;
+  for (; (data < end) && (*data >= '0') && (*data <= '9'); ++data)
+  {
+    value = value * 10 + (*data - '0');
+    if (value > (u64)LLONG_MAX) throw "Error: Invalid range list!";
+  }
+  while ((data < end) && ((*data == ' ') || (*data == '\t'))) ++data;
+  return value;
+}
+
+//-----------------------------------------------------------------------------
+time_intervals anomaly::decode_range_list(char const *data, size_t size,
+  bool unitsize, timestamp &count)
+{
+  static const char header[] = "length";
+  char const *end = data + size;
+  char const *eol = (char const *)memchr(data, '\n', size);
+  if (eol == NULL) eol = end;
+  char const *line_end = ((eol > data) && (eol[-1] == '\r')) ? eol - 1 : eol;
+
+  char const *pos = data + 1; // After '#'
+  while ((pos < line_end) && ((*pos == ' ') || (*pos == '\t'))) ++pos;
+  if ((line_end - pos < (ptrdiff_t)sizeof(header) - 1) ||
+      (memcmp(pos, header, sizeof(header) - 1) != 0))
+    throw "Error: Invalid range list!";
+  pos += sizeof(header) - 1;
+  u64 length = get_number(pos, line_end);
+  if (pos != line_end) throw "Error: Invalid range list!";
+
+  time_intervals anomalies;
+  bool started = false;
+  for (char const *line = eol + 1; line < end; line = eol + 1)
+  {
+    eol = (char const *)memchr(line, '\n', end - line);
+    if (eol == NULL) eol = end;
+    line_end = ((eol > line) && (eol[-1] == '\r')) ? eol - 1 : eol;
+
+    pos = line;
+    while ((pos < line_end) && ((*pos == ' ') || (*pos == '\t'))) ++pos;
+    if ((pos == line_end) || (*pos == '#')) continue;
+
+    u64 first = get_number(pos, line_end);
+    if ((pos == line_end) || (*pos++ != ',')) 
+      throw "Error: Invalid range list!";
+    u64 second = get_number(pos, line_end);
+    if (pos != line_end) throw "Error: Invalid range list!";
+
+    u64 previous_end = started ? (u64)anomalies.back().second : 0;
+    if ((first > second) || (second >= length) || 
+        (started && (first <= previous_end)))
+      throw "Error: Invalid range list!";
+
+    if (unitsize)
+    {
+      for (u64 t = first; t <= second; ++t)
+        anomalies.push_back(time_range(t, t));
+    }
+    else if (started && (first == previous_end + 1))
+      anomalies.back().second = second;
+    else anomalies.push_back(time_range(first, second));
+    started = true;
+  }
+
+  count = (timestamp)length;
+  return anomalies;
+}
+
+//-----------------------------------------------------------------------------
+void anomaly::write_range_list(std::string const &path,
+  time_intervals const &anomalies, timestamp count)
+{
+  FILE *file = fopen(path.c_str(), "wb");
+  if (file == NULL) throw "Error: Could not open file!";
+
+  bool ok = fprintf(file, "# length %lld\n", count) > 0;
+  for (auto i = anomalies.begin(); ok && (i != anomalies.end()); ++i)
+    ok = fprintf(file, "%lld,%lld\n", i->first, i->second) > 0;
+
+  ok = (fclose(file) == 0) && ok;
+  if (!ok) throw "Error: Could not write file!";
+}
@@ -0,0 +1,102 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#ifndef INTERVAL_FILE_H_
+#define INTERVAL_FILE_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Binary interval file format (all integers little-endian):
+//
+//   offset  size  field
+//   0       4     magic "TSAI"
+//   4       4     format version (currently 1)
+//   8       4     flags (bit 0: ranges are varint/delta encoded)
+//   12      4     reserved, 0
+//   16      8     series length, i.e., number of labels
+//   24      8     number of ranges
+//   32      ...   ranges, sorted and disjoint (touching ones are joined)
+//
+// Plain ranges are stored as pairs of 64-bit (start, end) positions. With
+// the compact flag set, each range is stored as two unsigned LEB128 varints:
+// the gap to the end of the previous range (or the start of the first range)
+// and the range length minus one.
+//-----------------------------------------------------------------------------
+static const char interval_file_magic[4] = {'T', 'S', 'A', 'I'};
+static const unsigned interval_file_version = 1;
+static const unsigned interval_file_compact = 1;
+static const size_t interval_file_header_size = 32;
+
+// True if the given bytes start with the interval file magic number.
+bool is_interval_file(char const *data, size_t size);
+
+// Decode an interval file held in memory. In unitsize mode every anomalous
+// position becomes its own unit-size range, like read_file_unitsize.
+time_intervals decode_interval_file(char const *data, size_t size,
+  bool unitsize, timestamp &count);
+
+// Encode ranges over a series of count labels as an interval file.
+std::vector<char> encode_interval_file(time_intervals const &anomalies,
+  timestamp count, bool compact);
+
+void write_interval_file(std::string const &path,
+  time_intervals const &anomalies, timestamp count, bool compact);
+
+//-----------------------------------------------------------------------------
+// Range list format, a text counterpart of interval files for series too
+// long to write out label by label:
+//
+//   # length 86400000000
+//   1200,1299
+//   52000,52000
+//
+// The first line gives the series length, i.e., the number of labels. Every
+// other line holds an anomaly range "start,end" of label positions, both
+// inclusive; ranges must be sorted and disjoint, and ranges that touch are
+// joined, as they would be in a label file. Blank lines and further lines
+// starting with '#' are ignored.
+//-----------------------------------------------------------------------------
+
+// True if the given bytes start like a range list.
+bool is_range_list(char const *data, size_t size);
+
+// Decode a range list held in memory, like decode_interval_file.
+time_intervals decode_range_list(char const *data, size_t size,
+  bool unitsize, timestamp &count);
+
+void write_range_list(std::string const &path,
+  time_intervals const &anomalies, timestamp count);
+
+}
+
+#endif // INTERVAL_FILE_H_
@@ -0,0 +1,311 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#include "jobs.h"
+
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "grid.h"
+#include "point_evaluator.h"
+#include "reader.h"
+#include "thread_pool.h"
+
+using namespace anomaly;
+
+namespace
+{
+
+struct loaded_file
+{
+  time_intervals anomalies;
+  timestamp count;
+};
+
+typedef std::string file_key; // Path of a file, loaded as ranges
+typedef std::shared_future<std::shared_ptr<loaded_file> > file_future;
+
+//-----------------------------------------------------------------------------
+// Files shared by several jobs are loaded by the first job that needs them
+// and released after the last one is done with them.
+//-----------------------------------------------------------------------------
+class file_cache
+{
+public:
+
+  void add_user(file_key const &key)
+  {
+    ++entries_[key].users;
+  }
+
+  file_future get(file_key const &key)
+  {
+    std::promise<std::shared_ptr<loaded_file> > promise;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      entry &e = entries_[key];
+      if (e.started) return e.file;
+      e.started = true;
+      e.file = promise.get_future().share();
+    }
+
+    try
+    {
+      std::shared_ptr<loaded_file> file(new loaded_file);
+      file->anomalies = read_file(key, file->count);
+      promise.set_value(file);
+    }
+    catch (...)
+    {
+      promise.set_exception(std::current_exception());
+    }
+
+    std::lock_guard<std::mutex> guard(lock_);
+    return entries_[key].file;
+  }
+
+  // Loads a file ahead of its jobs, unless it is loading or no longer used.
+  void prefetch(file_key const &key)
+  {
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      entry &e = entries_[key];
+      if (e.started || (e.users == 0)) return;
+    }
+    get(key); // Errors are left to the jobs.
+  }
+
+  void release(file_key const &key)
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    entry &e = entries_[key];
+    if (--e.users == 0) e.file = file_future(); // Free the file.
+  }
+
+private:
+
+  struct entry
+  {
+    entry() : users(0), started(false) {}
+
+    int users;
+    bool started;
+    file_future file;
+  };
+
+  std::mutex lock_;
+  std::map<file_key, entry> entries_;
+};
+
+struct job_result
+{
+  job_result() : done(false), precision(0), recall(0), fscore(0) {}
+
+  bool done;
+  std::string error;
+  double precision;
+  double recall;
+  double fscore;
+};
+
+//-----------------------------------------------------------------------------
+file_key real_key(evaluation_job const &job)
+{
+  return job.real_file;
+}
+
+file_key predicted_key(evaluation_job const &job)
+{
+  return job.predicted_file;
+}
+
+//-----------------------------------------------------------------------------
+// Parameter value as given on the command line, with its plugin function.
+//-----------------------------------------------------------------------------
+std::string parameter_name(char const *value, std::string const &udf)
+{
+  return udf.empty() ? std::string(value) : value + (":" + udf);
+}
+
+//-----------------------------------------------------------------------------
+void evaluate_job(evaluation_job const &job, file_cache &files,
+  job_result &result)
+{
+  if ((job.metric_option != "-c") && (job.metric_option != "-t") &&
+      (job.metric_option != "-n"))
+    throw "Error: Invalid metric option!";
+
+  std::shared_ptr<loaded_file> real = files.get(real_key(job)).get();
+  std::shared_ptr<loaded_file> predicted = files.get(predicted_key(job)).get();
+
+  if (real->count != predicted->count)
+    throw "Error: Number of data items are different!";
+  if (real->count == 0) throw "Error: No data items!";
+
+  if (job.metric_option != "-t") // Points on the predicted side
+  {
+    point_evaluator e(real->anomalies, predicted->anomalies, real->count,
+                      job.metric_option == "-c", job.beta, job.alpha_r,
+                      job.gamma, job.delta_p, job.delta_r);
+    e.get_parameters().set_udfs(job.udfs);
+    e.update_precision();
+    e.update_recall();
+    e.update_fscore();
+
+    result.precision = e.get_precision();
+    result.recall = e.get_recall();
+    result.fscore = e.get_fscore();
+    return;
+  }
+
+  evaluator e(interval_span(real->anomalies),
+              interval_span(predicted->anomalies), job.beta, job.alpha_r,
+              job.gamma, job.delta_p, job.delta_r);
+  e.set_udfs(job.udfs);
+  e.update_precision();
+  e.update_recall();
+  e.update_fscore();
+
+  result.precision = e.get_precision();
+  result.recall = e.get_recall();
+  result.fscore = e.get_fscore();
+}
+
+}
+
+//-----------------------------------------------------------------------------
+bool anomaly::run_jobs(std::vector<evaluation_job> const &jobs,
+  unsigned threads, std::ostream &out)
+{
+  file_cache files;
+  for (auto j = jobs.begin(); j != jobs.end(); ++j)
+  {
+    files.add_user(real_key(*j));
+    files.add_user(predicted_key(*j));
+  }
+
+  std::vector<job_result> results(jobs.size());
+  std::mutex lock;
+  std::condition_variable finished;
+  size_t started = 0; // Jobs taken up by workers
+
+  thread_pool pool(threads);
+
+  // Look-ahead loading: files of the next jobs, in manifest order and up to
+  // one job per worker ahead of those started, are read on a thread of their
+  // own, so workers find them loaded instead of waiting on I/O.
+  size_t lookahead = pool.size();
+  bool stopped = false;
+  std::thread prefetch([&]
+  {
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        finished.wait(guard, 
+                      [&] { return stopped || (i < started + lookahead); });
+        if (stopped) return;
+      }
+      files.prefetch(real_key(jobs[i]));
+      files.prefetch(predicted_key(jobs[i]));
+    }
+  });
+
+  // Workers run their own tasks last-in first-out, so submitting in reverse
+  // makes every worker start with its earliest job.
+  for (size_t i = jobs.size(); i-- > 0; )
+  {
+    pool.submit([&, i]
+    {
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        ++started;
+        finished.notify_all();
+      }
+
+      std::string error;
+      try
+      {
+        evaluate_job(jobs[i], files, results[i]);
+      }
+      catch (const char* msg)
+      {
+        error = msg;
+      }
+      catch (...)
+      {
+        error = "Error: Could not evaluate job!";
+      }
+      files.release(real_key(jobs[i]));
+      files.release(predicted_key(jobs[i]));
+
+      std::lock_guard<std::mutex> guard(lock);
+      results[i].error = error;
+      results[i].done = true;
+      finished.notify_all();
+    });
+  }
+
+  bool ok = true;
+  out << "job,metric,real_file,predicted_file,beta,alpha_r,gamma,delta_p,"
+      << "delta_r,precision,recall,fscore,error\n";
+
+  for (size_t i = 0; i < jobs.size(); ++i)
+  {
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      finished.wait(guard, [&] { return results[i].done; });
+    }
+
+    evaluation_job const &j = jobs[i];
+    job_result const &r = results[i];
+    out << i + 1 << "," << j.metric_option << "," << j.real_file << ","
+        << j.predicted_file << "," << j.beta << "," << j.alpha_r << ","
+        << parameter_name(cardinality_name(j.gamma), j.gamma_udf) << ","
+        << parameter_name(bias_name(j.delta_p), j.delta_p_udf) << ","
+        << parameter_name(bias_name(j.delta_r), j.delta_r_udf) << ",";
+    if (r.error.empty())
+      out << r.precision << "," << r.recall << "," << r.fscore << ",\n";
+    else
+    {
+      out << ",,," << r.error << "\n";
+      ok = false;
+    }
+    out.flush();
+  }
+
+  pool.wait();
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopped = true;
+    finished.notify_all();
+  }
+  prefetch.join();
+  return ok;
+}
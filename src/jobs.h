@@ -0,0 +1,73 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#ifndef JOBS_H_
+#define JOBS_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// One evaluation, as it would be given on the command line.
+//-----------------------------------------------------------------------------
+struct evaluation_job
+{
+  std::string metric_option; // -c, -t or -n
+  std::string real_file;
+  std::string predicted_file;
+
+  double beta;
+  double alpha_r;
+  overlap_cardinality gamma;
+  positional_bias delta_p;
+  positional_bias delta_r;
+
+  // Plugin functions selected as udf_gamma:<name> or udf_delta:<name>, and
+  // their names (empty for the compiled-in udfs).
+  udf_functions udfs;
+  std::string gamma_udf;
+  std::string delta_p_udf;
+  std::string delta_r_udf;
+};
+
+//-----------------------------------------------------------------------------
+// Runs all jobs on a work-stealing pool of the given number of threads (0 for
+// one per hardware thread) and writes one CSV row per job to out, in job
+// order, as soon as all earlier jobs are done. Each file is loaded once and
+// shared by the jobs that use it. Returns false if any job failed; its error
+// is reported in its row.
+//-----------------------------------------------------------------------------
+bool run_jobs(std::vector<evaluation_job> const &jobs, unsigned threads,
+  std::ostream &out);
+
+}
+
+#endif // JOBS_H_
@@ -24,143 +24,577 @@ SOFTWARE.
 
 */
 
+#include <climits>
 #include <fstream>
 #include <iostream>
+#include <new>
+#include <sstream>
 #include <stdlib.h>
 #include <string>
 
+#include "bootstrap.h"
+#include "channels.h"
+#include "contributions.h"
 #include "evaluator.h"
+#include "grid.h"
+#include "interval_file.h"
+#include "jobs.h"
+#include "nab.h"
+#include "point_evaluator.h"
+#include "pr_curve.h"
+#include "reader.h"
+#include "result_cache.h"
+#include "server.h"
+#include "stats.h"
+#include "stream_evaluator.h"
+#include "thread_pool.h"
+#include "udf_library.h"
+#include "window_index.h"
 
 using namespace std;
 using namespace anomaly;
 
+udf_library plugin; // Loaded with -u
+run_stats stats;    // Enabled with --stats or --stats-json
+result_cache cache; // Enabled with --cache
+
+//----------------------------------------------------------------------------
+// Given a positional bias value as of type string, convert it into
+// its corresponding value of enumerated type positional_bias.
+//----------------------------------------------------------------------------
+positional_bias convert_bias(string bias)
+{
+  if (bias == "flat") return e_flat;
+  else if (bias == "front") return e_front;
+  else if (bias == "middle") return e_middle;
+  else if (bias == "back") return e_back;
+  else if (bias == "udf_delta") return e_udf_delta;
+  else if (bias == "x") return e_flat; // I don't care. Set to default.
+
+  throw "Error: Invalid positional bias value!";
+}
+
+//----------------------------------------------------------------------------
+// Given an overlap cardinality value as of type string, convert it into
+// its corresponding value of enumerated type overlap_cardinality.
 //----------------------------------------------------------------------------
-// Given an input data file consisting of 0/1 anomaly labels,
-// read it into a vector of anomaly time intervals as well
-// as counting the total number of label entries in the file.
+overlap_cardinality convert_cardinality(string cardinality)
+{
+  if (cardinality == "one") return e_one;
+  else if (cardinality == "reciprocal") return e_reciprocal;
+  else if (cardinality == "udf_gamma") return e_udf_gamma;
+  else if (cardinality == "x") return e_one; // I don't care. Set to default.
+
+  throw "Error: Invalid overlap cardinality value!";
+}
+
+//----------------------------------------------------------------------------
+// Given a parameter value, possibly of the form "udf_gamma:<name>" or
+// "udf_delta:<name>", return it without the name of the plugin function,
+// which is stored in name. All udf values of one parameter list must name
+// the same function; seen tells whether one was already found.
 //----------------------------------------------------------------------------
-time_intervals read_file(ifstream &data, int &count)
+string split_udf(string value, string &name, bool &seen)
 {
-  time_intervals anomalies;
+  size_t colon = value.find(':');
+  string base = value.substr(0, colon);
+  if (base.compare(0, 4, "udf_") != 0) return value;
 
-  int i = 0;
-  int label;
-  time_range range;
-  bool range_started = false;
+  string udf = (colon == string::npos) ? "" : value.substr(colon + 1);
+  if (seen && (udf != name))
+    throw "Error: A parameter list can only use one user-defined function!";
+  seen = true;
+  name = udf;
+  return base;
+}
 
-  while (data >> label)
+//----------------------------------------------------------------------------
+// Look up the plugin functions named in a job.
+//----------------------------------------------------------------------------
+void resolve_udfs(evaluation_job &job)
+{
+  if (!job.gamma_udf.empty())
+    job.udfs.gamma = plugin.find_gamma(job.gamma_udf);
+  if (!job.delta_p_udf.empty())
+    job.udfs.delta_p = plugin.find_delta(job.delta_p_udf);
+  if (!job.delta_r_udf.empty())
+    job.udfs.delta_r = plugin.find_delta(job.delta_r_udf);
+}
+
+//----------------------------------------------------------------------------
+// Split a comma-separated list of parameter values.
+//----------------------------------------------------------------------------
+vector<string> split_list(string list)
+{
+  vector<string> values;
+  size_t start = 0, end;
+  while ((end = list.find(',', start)) != string::npos)
+  {
+    values.push_back(list.substr(start, end - start));
+    start = end + 1;
+  }
+  values.push_back(list.substr(start));
+  return values;
+}
+
+//----------------------------------------------------------------------------
+// Given the five parameter arguments as comma-separated lists (or NULL for
+// the defaults), build the grid of all their combinations. Plugin functions
+// are stored in job.
+//----------------------------------------------------------------------------
+parameter_grid convert_grid(char *params[], evaluation_job &job)
+{
+  parameter_grid grid;
+  bool seen = false;
+
+  if (params == NULL)
   {
-    data.ignore(INT_MAX, '\n'); // Ignore everything else other than label.
+    grid.betas.push_back(1);
+    grid.alpha_rs.push_back(0);
+    grid.gammas.push_back(e_one);
+    grid.delta_ps.push_back(e_flat);
+    grid.delta_rs.push_back(e_flat);
+    return grid;
+  }
+
+  vector<string> values = split_list(params[0]);
+  for (auto i = values.begin(); i != values.end(); ++i)
+  {
+    double beta = atof(i->c_str());
+    if (beta < 0) throw "Error: Invalid beta value!";
+    grid.betas.push_back(beta);
+  }
+
+  values = split_list(params[1]);
+  for (auto i = values.begin(); i != values.end(); ++i)
+  {
+    double alpha_r = atof(i->c_str());
+    if ((alpha_r < 0) || (alpha_r > 1.0)) throw "Error: Invalid alpha_r value!";
+    grid.alpha_rs.push_back(alpha_r);
+  }
+
+  values = split_list(params[2]);
+  for (auto i = values.begin(); i != values.end(); ++i)
+    grid.gammas.push_back(convert_cardinality(split_udf(*i, job.gamma_udf,
+                                                        seen)));
+
+  values = split_list(params[3]);
+  seen = false;
+  for (auto i = values.begin(); i != values.end(); ++i)
+    grid.delta_ps.push_back(convert_bias(split_udf(*i, job.delta_p_udf, seen)));
 
-    if (label == 1) // Anomaly.
+  values = split_list(params[4]);
+  seen = false;
+  for (auto i = values.begin(); i != values.end(); ++i)
+    grid.delta_rs.push_back(convert_bias(split_udf(*i, job.delta_r_udf, seen)));
+
+  resolve_udfs(job);
+  return grid;
+}
+
+//----------------------------------------------------------------------------
+// Given the arguments of one evaluation (metric option, data files, and
+// optionally the five parameters), convert them into a job description.
+//----------------------------------------------------------------------------
+evaluation_job convert_job(vector<string> const &args)
+{
+  if ((args.size() != 3) && (args.size() != 8))
+    throw "Error: Invalid number of arguments!";
+
+  evaluation_job job;
+  job.metric_option = args[0];
+  if ((job.metric_option != "-c") && (job.metric_option != "-t") &&
+      (job.metric_option != "-n"))
+    throw "Error: Invalid metric option!";
+  job.real_file = args[1];
+  job.predicted_file = args[2];
+
+  job.beta = (args.size() == 8) ? atof(args[3].c_str()) : 1;
+  if (job.beta < 0) throw "Error: Invalid beta value!";
+  job.alpha_r = (args.size() == 8) ? atof(args[4].c_str()) : 0;
+  if ((job.alpha_r < 0) || (job.alpha_r > 1.0))
+    throw "Error: Invalid alpha_r value!";
+  job.gamma = e_one;
+  job.delta_p = job.delta_r = e_flat;
+  if (args.size() == 8)
+  {
+    bool seen = false;
+    job.gamma = convert_cardinality(split_udf(args[5], job.gamma_udf, seen));
+    seen = false;
+    job.delta_p = convert_bias(split_udf(args[6], job.delta_p_udf, seen));
+    seen = false;
+    job.delta_r = convert_bias(split_udf(args[7], job.delta_r_udf, seen));
+    resolve_udfs(job);
+  }
+
+  return job;
+}
+
+//----------------------------------------------------------------------------
+// Given a manifest file with one job per line, each given by the same
+// arguments as on the command line, read it into a list of jobs. Empty
+// lines and lines starting with '#' are ignored.
+//----------------------------------------------------------------------------
+vector<evaluation_job> read_manifest(string const &path)
+{
+  ifstream manifest(path.c_str());
+  if (!manifest.is_open()) throw "Error: Could not open file!";
+
+  vector<evaluation_job> jobs;
+  string line;
+  int line_number = 0;
+  while (getline(manifest, line))
+  {
+    ++line_number;
+
+    istringstream tokens(line);
+    vector<string> args;
+    string token;
+    while (tokens >> token) args.push_back(token);
+    if (args.empty() || (args[0][0] == '#')) continue;
+
+    try
     {
-      if (!range_started) 
-      {
-        range_started = true;
-        range.first = i; 
-        range.second = i;
-      }
-      else range.second = i;
+      jobs.push_back(convert_job(args));
     }
-    else if (label == 0) // Not anomaly.
+    catch (const char* msg)
     {
-      if (range_started)
-      {
-        anomalies.push_back(range);
-        range_started = false;
-      }
-      else
-      {
-        // Nothing to do, keep reading.
-      }
+      cerr << path << ":" << line_number << ": ";
+      throw;
     }
-    else 
+  }
+
+  return jobs;
+}
+
+//----------------------------------------------------------------------------
+// Evaluate two label files read in lockstep, e.g., from pipes fed by a live
+// detector, printing the current metrics every "every" labels.
+//----------------------------------------------------------------------------
+int run_stream(evaluation_job const &job, int every)
+{
+  if (job.metric_option != "-t")
+  {
+    cerr << "Error: Streaming requires time series metrics (-t)!" << endl;
+    return 1;
+  }
+
+  ifstream real_file, predicted_file;
+  if (job.real_file != "-") real_file.open(job.real_file.c_str());
+  if (job.predicted_file != "-") 
+    predicted_file.open(job.predicted_file.c_str());
+  istream &real_data = (job.real_file == "-") ? cin : real_file;
+  istream &predicted_data = (job.predicted_file == "-") ? cin : predicted_file;
+
+  if (((job.real_file != "-") && !real_file.is_open()) || 
+      ((job.predicted_file != "-") && !predicted_file.is_open()))
+  {
+    cerr << "Error: Could not open file!" << endl;
+    return 1;
+  }
+
+  stream_evaluator e(job.beta, job.alpha_r, job.gamma, job.delta_p, 
+                     job.delta_r);
+  e.get_parameters().set_udfs(job.udfs);
+  int real_label, predicted_label;
+
+  try
+  {
+    for (;;)
     {
-      throw "Error: Invalid anomaly label!";
+      bool more_real = static_cast<bool>(real_data >> real_label);
+      bool more_predicted = 
+        static_cast<bool>(predicted_data >> predicted_label);
+      if (more_real != more_predicted)
+        throw "Error: Number of data items are different!";
+      if (!more_real) break;
+
+      // Ignore everything else other than label.
+      real_data.ignore(INT_MAX, '\n');
+      predicted_data.ignore(INT_MAX, '\n');
+
+      e.push(real_label, predicted_label);
+      if (e.get_count() % every == 0)
+      {
+        cout << "Labels = " << e.get_count() 
+             << ": Precision = " << e.get_precision() 
+             << ", Recall = " << e.get_recall() 
+             << ", F-Score = " << e.get_fscore() << endl;
+      }
     }
+    if (e.get_count() == 0) throw "Error: No data items!";
+
+    e.finish();
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
+
+  cout << "Precision = " << e.get_precision() << endl;
+  cout << "Recall = " << e.get_recall() << endl;
+  cout << "F-Score = " << e.get_fscore() << endl;
 
-    ++i;
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+// Given real labels and predicted anomaly scores, print the precision/recall
+// curve over all score thresholds and the area under it.
+//----------------------------------------------------------------------------
+int run_pr_curve(evaluation_job const &job)
+{
+  if (job.metric_option != "-t")
+  {
+    cerr << "Error: Score curves require time series metrics (-t)!" << endl;
+    return 1;
   }
 
-  if (range_started) // Last read label was an anomaly.
+  timestamp real_count = 0;
+  time_intervals real_anomalies;
+  vector<double> scores;
+  try
   {
-    anomalies.push_back(range);
-    range_started = false;
+    real_anomalies = cache.read_file(job.real_file, false, real_count);
+    scores = read_scores(job.predicted_file);
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
   }
 
-  count = i;
+  if ((size_t)real_count != scores.size())
+  {
+    cerr << "Error: Number of data items are different!" << endl;
+    return 1;
+  }
+  if (real_count == 0)
+  {
+    cerr << "Error: No data items!" << endl;
+    return 1;
+  }
+
+  evaluator params(time_intervals(), time_intervals(), job.beta, job.alpha_r,
+                   job.gamma, job.delta_p, job.delta_r);
+  params.set_udfs(job.udfs);
+  vector<pr_point> curve;
+  try
+  {
+    curve = compute_pr_curve(params, real_anomalies, scores);
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
 
-  return anomalies;
+  cout << "threshold,precision,recall,fscore\n";
+  for (auto p = curve.begin(); p != curve.end(); ++p)
+  {
+    cout << p->threshold << "," << p->precision << "," << p->recall << ","
+         << p->fscore << "\n";
+  }
+  cout << "PR-AUC = " << compute_pr_auc(curve) << endl;
+
+  return 0;
 }
 
 //----------------------------------------------------------------------------
-// Given an input data file consisting of 0/1 anomaly labels,
-// read it into a vector of unit-size anomaly time intervals as well
-// as counting the total number of label entries in the file.
+// Print the metrics of one evaluation.
 //----------------------------------------------------------------------------
-time_intervals read_file_unitsize(ifstream &data, int &count)
+void write_result(evaluation_result const &result)
 {
-  time_intervals anomalies;
+  cout << "Precision = " << result.precision << endl;
+  cout << "Recall = " << result.recall << endl;
+  cout << "F-Score = " << result.fscore << endl;
+  write_nab_scores(cout, result.nab);
+}
 
-  int i = 0;
-  int label;
-  time_range range;
+//----------------------------------------------------------------------------
+// Evaluate classical (-c) or numenta-like (-n) metrics, whose predicted
+// anomalies are points, with bitsets instead of unit-size ranges.
+//----------------------------------------------------------------------------
+int run_points(evaluation_job const &job, string const &result_key)
+{
+  timestamp real_count = 0, predicted_count = 0;
+  time_intervals real_anomalies, predicted_anomalies;
+  try
+  {
+    {
+      stats_phase phase(stats, "read_real");
+      real_anomalies = cache.read_file(job.real_file, false, real_count);
+    }
+    stats_phase phase(stats, "read_predicted");
+    predicted_anomalies = cache.read_file(job.predicted_file, false, 
+                                          predicted_count);
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
 
-  while (data >> label)
+  if (real_count != predicted_count)
   {
-    data.ignore(INT_MAX, '\n'); // Ignore everything else other than label.
+    cerr << "Error: Number of data items are different!" << endl;
+    return 1;
+  }
+  if (real_count == 0)
+  {
+    cerr << "Error: No data items!" << endl;
+    return 1;
+  }
+
+  try
+  {
+    point_evaluator e(real_anomalies, predicted_anomalies, real_count,
+                      job.metric_option == "-c", job.beta, job.alpha_r,
+                      job.gamma, job.delta_p, job.delta_r);
+    e.get_parameters().set_udfs(job.udfs);
 
-    if (label == 1) // Anomaly.
     {
-      range.first = i;
-      range.second = i;
-      anomalies.push_back(range);
+      stats_phase phase(stats, "precision");
+      e.update_precision();
     }
-    else if (label == 0) // Not anomaly.
     {
-      // Nothing to do, keep reading.
+      stats_phase phase(stats, "recall");
+      e.update_recall();
     }
-    else
+    e.update_fscore();
+
+    evaluation_result result;
+    result.precision = e.get_precision();
+    result.recall = e.get_recall();
+    result.fscore = e.get_fscore();
+    if (job.metric_option == "-n")
+      result.nab = compute_nab_scores(interval_span(real_anomalies), 
+                                      interval_span(predicted_anomalies));
+
+    write_result(result);
+    if (!result_key.empty()) cache.store_result(result_key, result);
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+// Evaluate every channel of multi-column data files (-w), parsing each file
+// once, and print per-channel and averaged metrics.
+//----------------------------------------------------------------------------
+int run_channels(evaluation_job const &job, unsigned threads)
+{
+  if (threads == 0) threads = thread_pool::hardware_threads();
+
+  timestamp real_count = 0, predicted_count = 0;
+  vector<time_intervals> real_channels, predicted_channels;
+  try
+  {
     {
-      throw "Error: Invalid anomaly label!";
+      stats_phase phase(stats, "read_real");
+      real_channels = read_columns(job.real_file, threads, real_count);
     }
+    stats_phase phase(stats, "read_predicted");
+    predicted_channels = read_columns(job.predicted_file, threads, 
+                                      predicted_count);
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
 
-    ++i;
+  if (real_count != predicted_count)
+  {
+    cerr << "Error: Number of data items are different!" << endl;
+    return 1;
+  }
+  if (real_count == 0)
+  {
+    cerr << "Error: No data items!" << endl;
+    return 1;
   }
 
-  count = i;
+  try
+  {
+    channel_summary summary;
+    {
+      stats_phase phase(stats, "channels");
+      summary = evaluate_channels(real_channels, predicted_channels,
+                                  real_count, job, threads);
+    }
+    write_channels(cout, summary);
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
 
-  return anomalies;
+  return 0;
 }
 
 //----------------------------------------------------------------------------
-// Given a positional bias value as of type string, convert it into
-// its corresponding value of enumerated type positional_bias.
+// Parse a comma-separated list of time windows "<first>:<last>" (-q).
 //----------------------------------------------------------------------------
-positional_bias convert_bias(string bias)
+vector<time_range> convert_windows(string const &list)
 {
-  if (bias == "flat") return e_flat;
-  else if (bias == "front") return e_front;
-  else if (bias == "middle") return e_middle;
-  else if (bias == "back") return e_back;
-  else if (bias == "udf_delta") return e_udf_delta;
-  else if (bias == "x") return e_flat; // I don't care. Set to default.
-
-  throw "Error: Invalid positional bias value!";
+  vector<time_range> windows;
+  stringstream stream(list);
+  string item;
+  while (getline(stream, item, ','))
+  {
+    size_t colon = item.find(':');
+    if (colon == string::npos) throw "Error: Invalid time window!";
+    char *end1, *end2;
+    long long first = strtoll(item.c_str(), &end1, 10);
+    long long last = strtoll(item.c_str() + colon + 1, &end2, 10);
+    if ((end1 != item.c_str() + colon) || (*end2 != '\0') || 
+        (first < 0) || (first > last))
+      throw "Error: Invalid time window!";
+    windows.push_back(time_range(first, last));
+  }
+  if (windows.empty()) throw "Error: Invalid time window!";
+  return windows;
 }
 
 //----------------------------------------------------------------------------
-// Given an overlap cardinality value as of type string, convert it into
-// its corresponding value of enumerated type overlap_cardinality.
+// Print the metrics of time windows (-q) or of a timeline of windows of the
+// given length (-l) as CSV.
 //----------------------------------------------------------------------------
-overlap_cardinality convert_cardinality(string cardinality)
+int run_windows(evaluator const &e, timestamp count, 
+  vector<time_range> const &windows, timestamp timeline_length)
 {
-  if (cardinality == "one") return e_one;
-  else if (cardinality == "reciprocal") return e_reciprocal;
-  else if (cardinality == "udf_gamma") return e_udf_gamma;
-  else if (cardinality == "x") return e_one; // I don't care. Set to default.
+  try
+  {
+    stats_phase phase(stats, "windows");
+    window_index index(e);
 
-  throw "Error: Invalid overlap cardinality value!";
+    vector<window_metrics> results;
+    if (timeline_length > 0) index.timeline(timeline_length, count, results);
+    for (auto w = windows.begin(); w != windows.end(); ++w)
+      results.push_back(index.query(w->first, w->second));
+
+    cout << "first,last,precision,recall,fscore\n";
+    for (auto r = results.begin(); r != results.end(); ++r)
+    {
+      cout << r->first << "," << r->last << "," << r->precision << "," 
+           << r->recall << "," << r->fscore << "\n";
+    }
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
+
+  return 0;
 }
 
 //----------------------------------------------------------------------------
@@ -169,14 +603,157 @@ void output_usage(char *argv[])
   cout << endl;
   cout << "Usage: " << endl;
   cout << argv[0] 
-       << " {-v} [-c | -t | -n] <real_data_file> <predicted_data_file>"
+       << " {-v} {-r} [-c | -t | -n] <real_data_file> <predicted_data_file>"
+       << endl;
+  cout << argv[0] 
+       << " {-v} {-r} {-u <plugin>} [-c | -t | -n] <real_data_file>"
+       << " <predicted_data_file> <beta> <alpha_r> <gamma> <delta_p> <delta_r>" 
+       << endl; 
+  cout << argv[0] 
+       << " {-v} {-r} -g [csv | json] [-c | -t | -n] <real_data_file>"
+       << " <predicted_data_file> {<betas> <alpha_rs> <gammas> <delta_ps>"
+       << " <delta_rs>}" 
+       << endl; 
+  cout << argv[0] 
+       << " -b <resamples> {-k <block_length>} {-x <seed>} {-j <threads>}"
+       << " [-c | -t | -n] <real_data_file> <predicted_data_file>"
+       << " {<beta> <alpha_r> <gamma> <delta_p> <delta_r>}"
+       << endl; 
+  cout << argv[0] 
+       << " -e [csv | bin] <export_file> [-c | -t | -n] <real_data_file>"
+       << " <predicted_data_file>"
+       << " {<beta> <alpha_r> <gamma> <delta_p> <delta_r>}"
+       << endl; 
+  cout << argv[0] 
+       << " [-q <first>:<last>{,<first>:<last>} | -l <window_length>]"
+       << " [-c | -t | -n] <real_data_file> <predicted_data_file>"
+       << " {<beta> <alpha_r> <gamma> <delta_p> <delta_r>}"
+       << endl; 
+  cout << argv[0] 
+       << " -w {-j <threads>} [-c | -t | -n] <real_data_file>"
+       << " <predicted_data_file>"
+       << " {<beta> <alpha_r> <gamma> <delta_p> <delta_r>}"
+       << endl; 
+  cout << argv[0] 
+       << " {-j <threads>} -m <manifest_file>"
+       << endl; 
+  cout << argv[0] 
+       << " -p -t <real_data_file> <score_file>"
+       << " {<beta> <alpha_r> <gamma> <delta_p> <delta_r>}" 
+       << endl; 
+  cout << argv[0] 
+       << " -s <every> -t <real_data_file> <predicted_data_file>"
+       << " {<beta> <alpha_r> <gamma> <delta_p> <delta_r>}" 
+       << endl; 
+  cout << argv[0] 
+       << " convert {-z | -s} <data_file> <interval_file>"
+       << endl; 
+  cout << argv[0] 
+       << " serve {-j <threads>} <socket>"
+       << endl; 
+  cout << argv[0] 
+       << " client <socket> [-c | -t | -n] <real_data_file>"
+       << " <predicted_data_file>"
+       << " {<beta> <alpha_r> <gamma> <delta_p> <delta_r>}"
+       << endl; 
+  cout << "    -v        : " 
+       << "Produce verbose output." 
+       << endl;
+  cout << "    -r        : " 
+       << "Use the reference all-pairs engine (slow, for validation)." 
+       << endl;
+  cout << "    -u        : " 
+       << "Load user-defined functions from a plugin shared object, used as" 
+       << endl;
+  cout << "                " 
+       << "udf_gamma:<name> and udf_delta:<name> (see udf_plugin.h)." 
+       << endl;
+  cout << "    -g        : " 
+       << "Evaluate all combinations of comma-separated parameter lists" 
+       << endl;
+  cout << "                " 
+       << "in one pass and print them as a CSV or JSON table." 
+       << endl;
+  cout << "    -m        : " 
+       << "Run the jobs listed in a manifest file, one per line, given by" 
+       << endl;
+  cout << "                " 
+       << "the arguments above after the modifier options." 
+       << endl;
+  cout << "    -p        : " 
+       << "Compute the precision/recall curve and its area over all" 
+       << endl;
+  cout << "                " 
+       << "thresholds of anomaly scores, given instead of predicted labels." 
+       << endl;
+  cout << "    -s        : " 
+       << "Read both data files as streams, in lockstep, and print the" 
+       << endl;
+  cout << "                " 
+       << "current metrics every <every> labels." 
+       << endl;
+  cout << "    -e        : " 
+       << "Also write the reward breakdown of every real and predicted range" 
+       << endl;
+  cout << "                " 
+       << "to <export_file>, as CSV or columnar binary (see contributions.h)." 
+       << endl;
+  cout << "    -q        : " 
+       << "Print the metrics of the given time windows of labels as CSV," 
+       << endl;
+  cout << "                " 
+       << "as if the data files held only those labels." 
+       << endl;
+  cout << "    -l        : " 
+       << "Print the metrics of consecutive windows of <window_length>" 
+       << endl;
+  cout << "                " 
+       << "labels over the whole series as CSV." 
+       << endl;
+  cout << "    -w        : " 
+       << "Read data files with a label column per channel, evaluate every" 
+       << endl;
+  cout << "                " 
+       << "channel and print micro and macro averages as well." 
+       << endl;
+  cout << "    -b        : " 
+       << "Bootstrap 95% confidence intervals of the metrics from" 
+       << endl;
+  cout << "                " 
+       << "<resamples> resamples of ranges, or of blocks of <block_length>" 
+       << endl;
+  cout << "                " 
+       << "labels with -k, drawn with the given seed (-x, Default = 1)." 
        << endl;
-  cout << argv[0] 
-       << " {-v} [-c | -t | -n] <real_data_file> <predicted_data_file>"
-       << " <beta> <alpha_r> <gamma> <delta_p> <delta_r>" 
-       << endl; 
-  cout << "    -v        : " 
-       << "Produce verbose output." 
+  cout << "    -j        : " 
+       << "Number of threads to use, Default = 1 for a single evaluation," 
+       << endl;
+  cout << "                " 
+       << "all hardware threads for a manifest, channels or bootstrap." 
+       << endl;
+  cout << "    --stats   : " 
+       << "Print phase times, peak memory and hot-path counters to stderr," 
+       << endl;
+  cout << "                " 
+       << "or as JSON to a file with --stats-json <file>, for any of the" 
+       << endl;
+  cout << "                " 
+       << "above." 
+       << endl;
+  cout << "    --cache   : " 
+       << "Reuse results and parsed files from the cache in <dir>, holding" 
+       << endl;
+  cout << "                " 
+       << "at most --cache-limit <MiB> (Default = 1024), for a single" 
+       << endl;
+  cout << "                " 
+       << "evaluation." 
+       << endl;
+  cout << "    --digits  : " 
+       << "Print metrics with <n> significant digits (Default = 6), where 17" 
+       << endl;
+  cout << "                " 
+       << "tell any two results apart." 
        << endl;
   cout << "    -c        : " 
        << "Compute classical metrics." 
@@ -185,7 +762,28 @@ void output_usage(char *argv[])
        << "Compute time series metrics." 
        << endl;
   cout << "    -n        : " 
-       << "Compute numenta-like metrics." 
+       << "Compute numenta-like metrics, and NAB scores of the standard" 
+       << endl;
+  cout << "                " 
+       << "application profiles with real ranges as anomaly windows." 
+       << endl;
+  cout << "    convert   : " 
+       << "Write a data file as a binary interval file, which can be used" 
+       << endl;
+  cout << "                " 
+       << "in place of any data file. -z uses compact varint encoding." 
+       << endl;
+  cout << "                " 
+       << "-s writes a text range list (\"# length <n>\", then \"start,end\")." 
+       << endl;
+  cout << "    serve     : " 
+       << "Serve evaluations on a Unix domain socket, keeping real data" 
+       << endl;
+  cout << "                " 
+       << "files parsed between requests (see src/server.h)." 
+       << endl;
+  cout << "    client    : " 
+       << "Evaluate through a running server." 
        << endl;
   cout << "    <beta>    : " 
        << "F-Score parameter (relative importance of Recall vs. Precision)." 
@@ -203,7 +801,7 @@ void output_usage(char *argv[])
        << "Customizable overlap cardinality function for Precision&Recall." 
        << endl;
   cout << "                " 
-       << "Values = {one, reciprocal, udf_gamma}" 
+       << "Values = {one, reciprocal, udf_gamma, udf_gamma:<name>}" 
        << endl;
   cout << "                " 
        << "Default = one, Most common = reciprocal" 
@@ -212,7 +810,7 @@ void output_usage(char *argv[])
        << "Customizable positional bias function for Precision." 
        << endl;
   cout << "                " 
-       << "Values = {flat, front, middle, back, udf_delta}" 
+       << "Values = {flat, front, middle, back, udf_delta, udf_delta:<name>}" 
        << endl;
   cout << "                " 
        << "Default = flat, Most common = flat" 
@@ -221,7 +819,7 @@ void output_usage(char *argv[])
        << "Customizable positional bias function for Recall." 
        << endl;
   cout << "                " 
-       << "Values = {flat, front, middle, back, udf_delta}" 
+       << "Values = {flat, front, middle, back, udf_delta, udf_delta:<name>}" 
        << endl;
   cout << "                " 
        << "Default = flat, Most common = {flat, front, back}" 
@@ -237,117 +835,420 @@ void output_usage(char *argv[])
 }
 
 //----------------------------------------------------------------------------
-int main(int argc, char *argv[])
+// Converts a label (or interval) file into a binary interval file, or into a
+// range list (-s).
+//----------------------------------------------------------------------------
+int convert(int argc, char *argv[])
 {
-  if ((argc != 4) && (argc != 9) && (argc !=5) && (argc != 10)) 
+  bool compact = false, ranges = false;
+  int offset = 0;
+  if ((argc == 5) && (string(argv[2]) == "-z"))
+  {
+    compact = true;
+    offset = 1;
+  }
+  else if ((argc == 5) && (string(argv[2]) == "-s"))
+  {
+    ranges = true;
+    offset = 1;
+  }
+  else if (argc != 4)
   {
     output_usage(argv);
     return 1;
   }
 
-  bool verbose = false;
+  try
+  {
+    timestamp count = 0;
+    time_intervals anomalies = read_file(argv[2+offset], count);
+    if (ranges) write_range_list(argv[3+offset], anomalies, count);
+    else write_interval_file(argv[3+offset], anomalies, count, compact);
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+// Runs the evaluation server on a Unix domain socket until interrupted.
+//----------------------------------------------------------------------------
+int serve(int argc, char *argv[])
+{
+  int threads = 0;
   int offset = 0;
-  if ((argc == 5) || (argc == 10))
+  if ((argc == 5) && (string(argv[2]) == "-j"))
   {
-    offset = 1;
-    string verbose_option = argv[1];
-    if (verbose_option == "-v")
-    {
-      verbose = true; 
-    }
-    else
+    threads = atoi(argv[3]);
+    if (threads < 1)
     {
-      cerr << "Error: Invalid verbose option!" << endl;
+      cerr << "Error: Invalid number of threads!" << endl;
       return 1;
     }
+    offset = 2;
+  }
+  else if (argc != 3)
+  {
+    output_usage(argv);
+    return 1;
+  }
+
+  try
+  {
+    run_server(argv[2+offset], threads);
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
   }
 
-  ifstream real_data(argv[2+offset]);
-  ifstream predicted_data(argv[3+offset]);
+  return 0;
+}
 
-  if (!real_data.is_open() || !predicted_data.is_open())
+//----------------------------------------------------------------------------
+// Evaluates through a running server: the predicted file is read here and
+// sent as ranges, the real file is read (once) by the server.
+//----------------------------------------------------------------------------
+int client(int argc, char *argv[])
+{
+  if (argc < 4)
   {
-    cerr << "Error: Could not open file!" << endl;
+    output_usage(argv);
     return 1;
   }
 
-  int real_count = 0, predicted_count = 0;
-  time_intervals real_anomalies, predicted_anomalies;
+  try
+  {
+    evaluation_job job = convert_job(vector<string>(argv + 3, argv + argc));
+
+    // The server may run in another directory.
+    char *real_path = realpath(job.real_file.c_str(), NULL);
+    if (real_path == NULL) throw "Error: Could not open file!";
+    job.real_file = real_path;
+    free(real_path);
+
+    timestamp count = 0;
+    time_intervals predicted = read_file(job.predicted_file, count);
 
-  string metric_option = argv[1+offset];  
-  if (metric_option == "-c") // Classical metrics
+    evaluation_result result;
+    server_connection connection(argv[2]);
+    connection.evaluate(job, predicted, count, result);
+    write_result(result);
+  }
+  catch (const char* msg)
   {
-    try
+    cerr << msg << endl;
+    return 1;
+  }
+  catch (string const &msg) // Reported by the server
+  {
+    cerr << msg << endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int run(int argc, char *argv[], string &stats_file)
+{
+  if ((argc > 1) && (string(argv[1]) == "convert")) return convert(argc, argv);
+  if ((argc > 1) && (string(argv[1]) == "serve")) return serve(argc, argv);
+  if ((argc > 1) && (string(argv[1]) == "client")) return client(argc, argv);
+
+  bool verbose = false;
+  bool reference = false;
+  string grid_format;
+  string manifest_file;
+  int threads = 0;
+  int stream_every = 0;
+  bool pr_curve = false;
+  bool wide = false;
+  string export_format, export_file;
+  vector<time_range> windows;
+  timestamp timeline_length = 0;
+  bootstrap_options bootstrapping;
+  bootstrapping.resamples = 0; // No bootstrap
+  string cache_dir;
+  long long cache_limit = 1024; // MiB
+  int offset = 0;
+  while ((1+offset < argc) && (argv[1+offset][0] == '-'))
+  {
+    string modifier_option = argv[1+offset];
+    if (modifier_option == "-v") verbose = true;
+    else if (modifier_option == "-r") reference = true;
+    else if (modifier_option == "-p") pr_curve = true;
+    else if (modifier_option == "-w") wide = true;
+    else if (modifier_option == "--stats") stats.enable();
+    else if ((modifier_option == "--cache") && (2+offset < argc))
     {
-      real_anomalies = read_file_unitsize(real_data, real_count);
+      cache_dir = argv[2+offset];
+      ++offset;
     }
-    catch (const char* msg)
+    else if ((modifier_option == "--cache-limit") && (2+offset < argc))
     {
-      cerr << msg << endl;
-      return 1;
+      cache_limit = atoll(argv[2+offset]);
+      if (cache_limit < 1)
+      {
+        cerr << "Error: Invalid cache size limit!" << endl;
+        return 1;
+      }
+      ++offset;
     }
-
-    try
+    else if ((modifier_option == "--digits") && (2+offset < argc))
     {
-      predicted_anomalies = read_file_unitsize(predicted_data, predicted_count);
+      int digits = atoi(argv[2+offset]);
+      if ((digits < 1) || (digits > 17))
+      {
+        cerr << "Error: Invalid number of digits!" << endl;
+        return 1;
+      }
+      cout.precision(digits);
+      ++offset;
     }
-    catch (const char* msg) 
+    else if ((modifier_option == "--stats-json") && (2+offset < argc))
     {
-      cerr << msg << endl;
-      return 1;
+      stats.enable();
+      stats_file = argv[2+offset];
+      ++offset;
+    }
+    else if ((modifier_option == "-g") && (2+offset < argc))
+    {
+      grid_format = argv[2+offset];
+      if ((grid_format != "csv") && (grid_format != "json"))
+      {
+        cerr << "Error: Invalid grid output format!" << endl;
+        return 1;
+      }
+      ++offset;
+    }
+    else if ((modifier_option == "-u") && (2+offset < argc))
+    {
+      try
+      {
+        plugin.open(argv[2+offset]);
+      }
+      catch (const char* msg)
+      {
+        cerr << msg << endl;
+        return 1;
+      }
+      ++offset;
+    }
+    else if ((modifier_option == "-m") && (2+offset < argc))
+    {
+      manifest_file = argv[2+offset];
+      ++offset;
+    }
+    else if ((modifier_option == "-s") && (2+offset < argc))
+    {
+      stream_every = atoi(argv[2+offset]);
+      if (stream_every < 1)
+      {
+        cerr << "Error: Invalid streaming interval!" << endl;
+        return 1;
+      }
+      ++offset;
+    }
+    else if ((modifier_option == "-e") && (3+offset < argc))
+    {
+      export_format = argv[2+offset];
+      export_file = argv[3+offset];
+      if ((export_format != "csv") && (export_format != "bin"))
+      {
+        cerr << "Error: Invalid export format!" << endl;
+        return 1;
+      }
+      offset += 2;
+    }
+    else if ((modifier_option == "-q") && (2+offset < argc))
+    {
+      try
+      {
+        windows = convert_windows(argv[2+offset]);
+      }
+      catch (const char* msg)
+      {
+        cerr << msg << endl;
+        return 1;
+      }
+      ++offset;
+    }
+    else if ((modifier_option == "-l") && (2+offset < argc))
+    {
+      timeline_length = atoll(argv[2+offset]);
+      if (timeline_length < 1)
+      {
+        cerr << "Error: Invalid window length!" << endl;
+        return 1;
+      }
+      ++offset;
+    }
+    else if ((modifier_option == "-b") && (2+offset < argc))
+    {
+      int resamples = atoi(argv[2+offset]);
+      if (resamples < 1)
+      {
+        cerr << "Error: Invalid number of resamples!" << endl;
+        return 1;
+      }
+      bootstrapping.resamples = resamples;
+      ++offset;
+    }
+    else if ((modifier_option == "-k") && (2+offset < argc))
+    {
+      bootstrapping.block_length = atoll(argv[2+offset]);
+      if (bootstrapping.block_length < 1)
+      {
+        cerr << "Error: Invalid block length!" << endl;
+        return 1;
+      }
+      ++offset;
+    }
+    else if ((modifier_option == "-x") && (2+offset < argc))
+    {
+      bootstrapping.seed = strtoull(argv[2+offset], NULL, 10);
+      ++offset;
     }
+    else if ((modifier_option == "-j") && (2+offset < argc))
+    {
+      threads = atoi(argv[2+offset]);
+      if (threads < 1)
+      {
+        cerr << "Error: Invalid number of threads!" << endl;
+        return 1;
+      }
+      ++offset;
+    }
+    else break; // Must be the metric option.
+    ++offset;
   }
-  else if (metric_option == "-t") // Time series metrics
+
+  int nargs = argc - offset;
+  if (!manifest_file.empty() && (nargs == 1)) // Jobs listed in a manifest.
   {
     try
     {
-      real_anomalies = read_file(real_data, real_count);
+      return run_jobs(read_manifest(manifest_file), threads, cout) ? 0 : 1;
     }
-    catch (const char* msg) 
+    catch (const char* msg)
     {
       cerr << msg << endl;
       return 1;
     }
+  }
+
+  if ((nargs != 4) && (nargs != 9))
+  {
+    output_usage(argv);
+    return 1;
+  }
 
+  if (!cache_dir.empty())
+  {
     try
     {
-      predicted_anomalies = read_file(predicted_data, predicted_count);
+      cache.open(cache_dir, (unsigned long long)cache_limit << 20);
     }
-    catch (const char* msg) 
+    catch (const char* msg)
     {
       cerr << msg << endl;
       return 1;
     }
   }
-  else if (metric_option == "-n") // Numenta-like metrics 
+
+  // In grid mode, parameters are lists and converted separately below.
+  evaluation_job job;
+  try
   {
-    try
-    {
-      real_anomalies = read_file(real_data, real_count);
-    }
-    catch (const char* msg) 
+    job = convert_job(vector<string>(argv + 1 + offset, 
+                                     grid_format.empty() ? argv + argc 
+                                                         : argv + 4 + offset));
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
+
+  bool windowed = !windows.empty() || (timeline_length > 0);
+  if (((bootstrapping.resamples > 0) || !export_file.empty() || windowed) && 
+      (wide || (stream_every > 0) || pr_curve || !grid_format.empty()))
+  {
+    cerr << "Error: -b, -e, -q and -l cannot be combined with -w, -s, -p"
+         << " or -g!" << endl;
+    return 1;
+  }
+  if ((bootstrapping.resamples > 0) + !export_file.empty() + windowed > 1)
+  {
+    cerr << "Error: Only one of -b, -e and -q or -l can be used!" << endl;
+    return 1;
+  }
+  if (wide)
+  {
+    if ((stream_every > 0) || pr_curve || !grid_format.empty() || reference ||
+        verbose)
     {
-      cerr << msg << endl;
+      cerr << "Error: -w cannot be combined with -s, -p, -g, -r or -v!" 
+           << endl;
       return 1;
     }
+    return run_channels(job, threads);
+  }
+  if (stream_every > 0) return run_stream(job, stream_every);
+  if (pr_curve) return run_pr_curve(job);
 
-    try
+  // Plain evaluations are looked up in the result cache (--cache) first,
+  // before any data file is parsed. Evaluations with -r or -v are not cached.
+  bool plain = grid_format.empty() && !reference && !verbose && 
+               (bootstrapping.resamples == 0) && export_file.empty() && 
+               !windowed;
+  string result_key;
+  if (plain && cache.is_open())
+  {
+    stats_phase phase(stats, "cache");
+    evaluation_result result;
+    if (!cache.make_key(job, result_key)) result_key.clear();
+    else if (cache.find_result(result_key, result))
     {
-      predicted_anomalies = read_file_unitsize(predicted_data, predicted_count);
+      write_result(result);
+      return 0;
     }
-    catch (const char* msg) 
+  }
+
+  // The reference engine (-r) and the listing of all ranges (-v) need the
+  // points as unit-size ranges.
+  if ((job.metric_option != "-t") && plain) return run_points(job, result_key);
+
+  timestamp real_count = 0, predicted_count = 0;
+  time_intervals real_anomalies, predicted_anomalies;
+
+  // Classical metrics (-c) use unit-size ranges for both real and predicted
+  // anomalies, time series metrics (-t) use ranges for both, and
+  // numenta-like metrics (-n) use ranges for real and points for predicted.
+  try
+  {
     {
-      cerr << msg << endl;
-      return 1;
+      stats_phase phase(stats, "read_real");
+      real_anomalies = cache.read_file(job.real_file, 
+                                       job.metric_option == "-c", real_count);
     }
+
+    stats_phase phase(stats, "read_predicted");
+    predicted_anomalies = cache.read_file(job.predicted_file, 
+                                          job.metric_option != "-t",
+                                          predicted_count);
   }
-  else 
+  catch (const char* msg)
   {
-    cerr << "Error: Invalid metric option!" << endl;
+    cerr << msg << endl;
     return 1;
   }
-  real_data.close();
-  predicted_data.close();
 
   if (real_count != predicted_count)
   {
@@ -360,54 +1261,92 @@ int main(int argc, char *argv[])
     return 1;
   }
 
-  evaluator e;
+  // Evaluators refer to the ranges read above instead of copying them.
+  interval_span real_span(real_anomalies);
+  interval_span predicted_span(predicted_anomalies);
 
-  if ((argc == 4) || (argc == 5))
-  {
-    e = evaluator(real_anomalies, predicted_anomalies);
-  }
-  else
+  if (!grid_format.empty()) // Parameter grid, all lists share one pass.
   {
-    double beta = atof(argv[4+offset]);
-    if (beta < 0)
+    parameter_grid grid;
+    try
+    {
+      grid = convert_grid((nargs == 9) ? &argv[4+offset] : NULL, job);
+    }
+    catch (const char* msg)
     {
-      cerr << "Error: Invalid beta value!" << endl;
+      cerr << msg << endl;
       return 1;
     }
 
-    double alpha_r = atof(argv[5+offset]);
-    if ((alpha_r < 0) || (alpha_r > 1.0))
+    evaluator e(real_span, predicted_span);
+    e.set_udfs(job.udfs);
+    if (reference) e.set_engine(e_nested);
+
+    if (verbose) // Print anomaly ranges.
     {
-      cerr << "Error: Invalid alpha_r value!" << endl;
-      return 1;
+      e.print_real_anomalies();
+      e.print_predicted_anomalies();
     }
 
-    overlap_cardinality gamma;
+    vector<grid_result> results;
     try
     {
-      gamma = convert_cardinality(argv[6+offset]);
+      stats_phase phase(stats, "grid");
+      results = evaluate_grid(e, grid);
     }
     catch (const char* msg)
     {
       cerr << msg << endl;
       return 1;
     }
+    if (grid_format == "json") write_grid_json(cout, results);
+    else write_grid_csv(cout, results);
+
+    return 0;
+  }
+
+  evaluator e(real_span, predicted_span, job.beta, job.alpha_r,
+              job.gamma, job.delta_p, job.delta_r);
+  e.set_udfs(job.udfs);
+
+  if (reference) e.set_engine(e_nested);
+  if (threads > 0) e.set_threads(threads);
 
-    positional_bias delta_p;
+  if (verbose) // Print anomaly ranges.
+  {
+    e.print_real_anomalies();
+    e.print_predicted_anomalies();
+  }
+
+  if (bootstrapping.resamples > 0) // Confidence intervals instead
+  {
+    bootstrapping.threads = threads;
     try
     {
-      delta_p = convert_bias(argv[7+offset]);
+      stats_phase phase(stats, "bootstrap");
+      write_bootstrap(cout, bootstrap(e, real_count, bootstrapping), 
+                      bootstrapping);
     }
     catch (const char* msg)
     {
       cerr << msg << endl;
       return 1;
     }
+    return 0;
+  }
 
-    positional_bias delta_r;
+  if (windowed) return run_windows(e, real_count, windows, timeline_length);
+
+  if (!export_file.empty()) // Metrics from the exported breakdown
+  {
+    double precision = 0, recall = 0;
     try
     {
-      delta_r = convert_bias(argv[8+offset]);
+      stats_phase phase(stats, "export");
+      export_contributions(e, export_file, (export_format == "csv") 
+                                           ? e_contributions_csv
+                                           : e_contributions_binary,
+                           precision, recall);
     }
     catch (const char* msg)
     {
@@ -415,24 +1354,94 @@ int main(int argc, char *argv[])
       return 1;
     }
 
-    e = evaluator(real_anomalies, predicted_anomalies, 
-                  beta, alpha_r, gamma, delta_p, delta_r);
+    cout << "Precision = " << precision << endl;
+    cout << "Recall = " << recall << endl;
+    cout << "F-Score = " << e.compute_fscore(precision, recall) << endl;
+    return 0;
   }
 
-  if (verbose) // Print anomaly ranges.
+  try
   {
-    e.print_real_anomalies();
-    e.print_predicted_anomalies();
+    {
+      stats_phase phase(stats, "precision");
+      e.update_precision();
+    }
+    {
+      stats_phase phase(stats, "recall");
+      e.update_recall();
+    }
+    e.update_fscore();
+  }
+  catch (const char* msg)
+  {
+    cerr << msg << endl;
+    return 1;
+  }
+
+  evaluation_result result;
+  result.precision = e.get_precision();
+  result.recall = e.get_recall();
+  result.fscore = e.get_fscore();
+  if (job.metric_option == "-n")
+  {
+    try
+    {
+      result.nab = compute_nab_scores(real_span, predicted_span);
+    }
+    catch (const char* msg)
+    {
+      cerr << msg << endl;
+      return 1;
+    }
   }
 
-  e.update_precision();
-  e.update_recall();
-  e.update_fscore();
+  write_result(result);
+  if (!result_key.empty()) cache.store_result(result_key, result);
 
-  cout << "Precision = " << e.get_precision() << endl;
-  cout << "Recall = " << e.get_recall() << endl;
-  cout << "F-Score = " << e.get_fscore() << endl;
+  if (verbose && 
+      ((e.get_delta_p() == e_udf_delta) || (e.get_delta_r() == e_udf_delta)))
+  {
+    cout << "UDF delta cache: hits = " << e.get_udf_cache_hits()
+         << ", misses = " << e.get_udf_cache_misses() << endl;
+  }
 
   return 0;
 }
 
+//----------------------------------------------------------------------------
+// Runs the command line and then reports the statistics of the run, if
+// requested, on stderr or in a JSON file.
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  string stats_file;
+  int status;
+  {
+    stats_phase phase(stats, "total");
+    try
+    {
+      status = run(argc, argv, stats_file);
+    }
+    catch (std::bad_alloc const &)
+    {
+      cerr << "Error: Out of memory!" << endl;
+      return 1;
+    }
+  }
+  if (!stats.is_enabled()) return status;
+
+  if (stats_file.empty())
+  {
+    stats.write_text(cerr);
+    return status;
+  }
+
+  ofstream out(stats_file.c_str());
+  stats.write_json(out);
+  if (!out)
+  {
+    cerr << "Error: Could not write the statistics file!" << endl;
+    return 1;
+  }
+  return status;
+}
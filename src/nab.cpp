@@ -0,0 +1,204 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "nab.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace anomaly;
+
+nab_profile const anomaly::nab_profiles[nab_profile_count] =
+{
+  {"standard", 1.0, 0.11, 1.0},
+  {"reward_low_FP_rate", 1.0, 0.22, 1.0},
+  {"reward_low_FN_rate", 1.0, 0.11, 2.0}
+};
+//-----------------------------------------------------------------------------
+static double scaled_sigmoid(double x)
+{
+  if (x > 3.0) return -1.0; // Far behind a window
+  return 2.0 / (1.0 + exp(5.0 * x)) - 1.0;
+}
+
+//-----------------------------------------------------------------------------
+// Sum of scaled_sigmoid(y) for y = y0, y0 + h, ... over n positions, all
+// with y <= 3. Runs of up to 2^16 positions are summed term by term, longer
+// ones by Euler-Maclaurin from the integral y - 0.4 log(1 + exp(5y)) of the
+// sigmoid; such runs have h < 2^-14, for an error of O(h^3).
+//-----------------------------------------------------------------------------
+static double sigmoid_sum(double y0, double h, long long n)
+{
+  static const long long max_terms = 1 << 16;
+
+  if (n <= max_terms)
+  {
+    double sum = 0;
+    for (long long k = 0; k < n; ++k) sum += scaled_sigmoid(y0 + k * h);
+    return sum;
+  }
+
+  auto integral = [](double y) { return y - 0.4 * log1p(exp(5.0 * y)); };
+  auto slope = [](double y)
+  {
+    double e = exp(5.0 * y);
+    return -10.0 * e / ((1.0 + e) * (1.0 + e));
+  };
+  double y1 = y0 + (n - 1) * h;
+  return (integral(y1) - integral(y0)) / h +
+         (scaled_sigmoid(y0) + scaled_sigmoid(y1)) / 2 +
+         h / 12 * (slope(y1) - slope(y0));
+}
+
+//-----------------------------------------------------------------------------
+// Sum of scaled_sigmoid(y) over false positives at positions first .. last,
+// with y = |previous_end - t| / scale: -1 each without a previous window or
+// beyond 3 * scale of it, which are counted in closed form.
+//-----------------------------------------------------------------------------
+static double false_positive_sum(long long first, long long last,
+  bool after_window, double previous_end, double scale)
+{
+  if (!after_window) return -(double)(last - first + 1);
+
+  // Last position near the window, as scaled_sigmoid decides it.
+  long long near_end = (long long)previous_end + (long long)(3.0 * scale);
+  while (fabs(previous_end - (near_end + 1)) / scale <= 3.0) ++near_end;
+  while (fabs(previous_end - near_end) / scale > 3.0) --near_end;
+
+  double sum = 0;
+  long long near_last = std::min(last, near_end);
+  if (first <= near_last)
+  {
+    sum += sigmoid_sum(fabs(previous_end - first) / scale, 1.0 / scale,
+                       near_last - first + 1);
+  }
+  long long far_first = std::max(first, near_end + 1);
+  if (far_first <= last) sum -= last - far_first + 1;
+  return sum;
+}
+
+//-----------------------------------------------------------------------------
+// One sweep over windows and detections in time order, a run of positions at
+// a time: the part of a detection inside a window, and the part between two
+// windows, so that the time does not depend on the lengths of the ranges.
+//-----------------------------------------------------------------------------
+nab_score anomaly::compute_nab_score(interval_span windows,
+  interval_span detections, nab_profile const &profile)
+{
+  if (!evaluator::is_sorted_disjoint(windows) ||
+      !evaluator::is_sorted_disjoint(detections))
+    throw "Error: NAB scoring needs sorted and disjoint ranges!";
+
+  double const max_tp = scaled_sigmoid(-1.0);
+
+  nab_score score;
+  score.raw = 0;
+  score.true_positives = score.false_positives = 0;
+
+  size_t w = 0;
+  bool detected = false; // Window w has been detected
+  bool after_window = false;
+  double previous_end = 0, previous_length = 0;
+
+  for (auto d = detections.begin(); d != detections.end(); )
+  {
+    // Touching detections, such as unit-size ones, are taken as one, so that
+    // the sums of false positives do not depend on how they are split.
+    long long first = d->first, end = d->second;
+    for (++d; (d != detections.end()) && (d->first == end + 1); ++d)
+      end = d->second;
+
+    for (long long t = first; t <= end; )
+    {
+      while ((w < windows.size()) && (windows[w].second < t))
+      {
+        if (detected) ++score.true_positives;
+        detected = false;
+        after_window = true;
+        previous_end = windows[w].second;
+        previous_length = windows[w].second - windows[w].first + 1;
+        ++w;
+      }
+
+      if ((w < windows.size()) && (windows[w].first <= t)) // In window w
+      {
+        if (!detected)
+        {
+          double length = windows[w].second - windows[w].first + 1;
+          double y = -(windows[w].second - t + 1) / length;
+          score.raw += profile.tp_weight * scaled_sigmoid(y) / max_tp;
+          detected = true;
+        }
+        t = windows[w].second + 1; // Later detections do not count
+        continue;
+      }
+
+      // False positives up to the end of the detection or the next window.
+      long long last = end;
+      if ((w < windows.size()) && (windows[w].first <= last))
+        last = windows[w].first - 1;
+      score.raw += profile.fp_weight *
+                   false_positive_sum(t, last, after_window, previous_end,
+                                      std::max(previous_length - 1, 1.0));
+      score.false_positives += last - t + 1;
+      t = last + 1;
+    }
+  }
+  if (detected) ++score.true_positives;
+
+  score.false_negatives = windows.size() - score.true_positives;
+  score.raw -= profile.fn_weight * score.false_negatives;
+
+  double null_score = -profile.fn_weight * windows.size();
+  double perfect_score = profile.tp_weight * windows.size();
+  score.normalized = (perfect_score > null_score)
+                   ? 100.0 * (score.raw - null_score) / 
+                     (perfect_score - null_score)
+                   : std::numeric_limits<double>::quiet_NaN();
+  return score;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<nab_score> anomaly::compute_nab_scores(interval_span windows,
+  interval_span detections)
+{
+  std::vector<nab_score> scores;
+  for (int p = 0; p < nab_profile_count; ++p)
+    scores.push_back(compute_nab_score(windows, detections, nab_profiles[p]));
+  return scores;
+}
+
+//-----------------------------------------------------------------------------
+void anomaly::write_nab_scores(std::ostream &out,
+  std::vector<nab_score> const &scores)
+{
+  for (size_t p = 0; p < scores.size(); ++p)
+  {
+    out << "NAB Score (" << nab_profiles[p].name << ") = " << scores[p].raw 
+        << ", Normalized = " << scores[p].normalized << std::endl;
+  }
+}
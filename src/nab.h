@@ -0,0 +1,91 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef NAB_H_
+#define NAB_H_
+
+#include <ostream>
+#include <vector>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Weights of an application profile of the Numenta Anomaly Benchmark (NAB).
+//-----------------------------------------------------------------------------
+struct nab_profile
+{
+  char const *name;
+  double tp_weight;
+  double fp_weight;
+  double fn_weight;
+};
+
+// The standard NAB profiles: standard, reward_low_FP_rate, reward_low_FN_rate
+static const int nab_profile_count = 3;
+extern nab_profile const nab_profiles[nab_profile_count];
+
+//-----------------------------------------------------------------------------
+// NAB score of binary detections (every position of the predicted ranges)
+// against anomaly windows (the real ranges):
+//
+// - The first detection in a window scores tp_weight * sigma(y) / sigma(-1),
+//   where y = -(window end - position + 1) / window length and sigma(x) =
+//   2 / (1 + exp(5x)) - 1. Later detections in the same window are ignored.
+// - A detection outside of all windows scores fp_weight * sigma(y), where y
+//   is its distance to the end of the previous window relative to that
+//   window's length - 1 (sigma = -1 for y > 3 or without a previous window).
+// - Every window without detections scores -fn_weight.
+//
+// The normalized score maps the raw score of a detector without detections
+// to 0 and that of a perfect one (detecting every window at its start) to
+// 100; it is undefined without windows.
+//-----------------------------------------------------------------------------
+struct nab_score
+{
+  double raw;
+  double normalized;
+  size_t true_positives;  // Detected windows
+  size_t false_positives; // Detections outside of windows
+  size_t false_negatives; // Windows without detections
+};
+
+// Both sides must be sorted and disjoint. Takes O(W + D) time for W windows
+// and D detections.
+nab_score compute_nab_score(interval_span windows, interval_span detections,
+  nab_profile const &profile);
+
+// Scores of all standard profiles, in the order of nab_profiles.
+std::vector<nab_score> compute_nab_scores(interval_span windows,
+  interval_span detections);
+
+void write_nab_scores(std::ostream &out, std::vector<nab_score> const &scores);
+
+}
+
+#endif // NAB_H_
@@ -0,0 +1,335 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "point_evaluator.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace anomaly;
+
+typedef unsigned long long u64;
+
+//-----------------------------------------------------------------------------
+// Bits lo .. hi-1 of a word, for 0 <= lo < hi <= 64.
+//-----------------------------------------------------------------------------
+static u64 bit_mask(unsigned lo, unsigned hi)
+{
+  u64 upper = (hi == 64) ? ~0ULL : ((1ULL << hi) - 1);
+  return upper & ~((1ULL << lo) - 1);
+}
+
+//-----------------------------------------------------------------------------
+// Population count of a[i] (& b[i], unless b is NULL) over n words. Where
+// the CPU has a popcount instruction, a copy compiled for it is used; the
+// generic build would otherwise count bits with a table in software.
+//-----------------------------------------------------------------------------
+#if defined(__GNUC__)
+__attribute__((always_inline))
+#endif
+static inline size_t count_bits_generic(u64 const *a, u64 const *b, size_t n)
+{
+  size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0, i = 0;
+
+  if (b == NULL)
+  {
+    for (; i + 4 <= n; i += 4)
+    {
+      c0 += __builtin_popcountll(a[i]);
+      c1 += __builtin_popcountll(a[i + 1]);
+      c2 += __builtin_popcountll(a[i + 2]);
+      c3 += __builtin_popcountll(a[i + 3]);
+    }
+    for (; i < n; ++i) c0 += __builtin_popcountll(a[i]);
+  }
+  else
+  {
+    for (; i + 4 <= n; i += 4)
+    {
+      c0 += __builtin_popcountll(a[i] & b[i]);
+      c1 += __builtin_popcountll(a[i + 1] & b[i + 1]);
+      c2 += __builtin_popcountll(a[i + 2] & b[i + 2]);
+      c3 += __builtin_popcountll(a[i + 3] & b[i + 3]);
+    }
+    for (; i < n; ++i) c0 += __builtin_popcountll(a[i] & b[i]);
+  }
+
+  return c0 + c1 + c2 + c3;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+__attribute__((target("popcnt")))
+static size_t count_bits_popcnt(u64 const *a, u64 const *b, size_t n)
+{
+  return count_bits_generic(a, b, n); // Inlined, hence compiled for popcnt.
+}
+
+static size_t count_bits(u64 const *a, u64 const *b, size_t n)
+{
+  static const bool has_popcnt = __builtin_cpu_supports("popcnt");
+  return has_popcnt ? count_bits_popcnt(a, b, n) : count_bits_generic(a, b, n);
+}
+#else
+static size_t count_bits(u64 const *a, u64 const *b, size_t n)
+{
+  return count_bits_generic(a, b, n);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+label_bitset::label_bitset(time_intervals const &anomalies, size_t size)
+: size_(size), words_((size + 63) / 64, 0)
+{
+  for (auto r = anomalies.begin(); r != anomalies.end(); ++r)
+  {
+    if ((r->first < 0) || (r->first > r->second) || 
+        ((size_t)r->second >= size))
+      throw "Error: Anomaly range out of bounds!";
+
+    size_t first = r->first, last = r->second;
+    size_t w = first / 64, last_w = last / 64;
+    if (w == last_w)
+    {
+      words_[w] |= bit_mask(first % 64, last % 64 + 1);
+      continue;
+    }
+
+    words_[w] |= bit_mask(first % 64, 64);
+    for (++w; w < last_w; ++w) words_[w] = ~0ULL;
+    words_[last_w] |= bit_mask(0, last % 64 + 1);
+  }
+}
+
+//-----------------------------------------------------------------------------
+size_t label_bitset::count() const
+{
+  return count_bits(words_.data(), NULL, words_.size());
+}
+
+//-----------------------------------------------------------------------------
+size_t label_bitset::count_and(label_bitset const &other) const
+{
+  if (other.size_ != size_) throw "Error: Number of data items are different!";
+  return count_bits(words_.data(), other.words_.data(), words_.size());
+}
+
+//-----------------------------------------------------------------------------
+// Bounds checks of label_bitset, for ranges that are not put into bitsets.
+//-----------------------------------------------------------------------------
+void point_evaluator::check_ranges(timestamp count) const
+{
+  time_intervals const *sides[] = {&real_ranges_, &predicted_ranges_};
+  for (auto side : sides)
+  {
+    for (auto r = side->begin(); r != side->end(); ++r)
+    {
+      if ((r->first < 0) || (r->first > r->second) || (r->second >= count))
+        throw "Error: Anomaly range out of bounds!";
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+static size_t range_points(time_intervals const &ranges)
+{
+  size_t points = 0;
+  for (auto r = ranges.begin(); r != ranges.end(); ++r)
+    points += r->second - r->first + 1;
+  return points;
+}
+
+//-----------------------------------------------------------------------------
+size_t point_evaluator::real_points() const
+{
+  return bitsets_ ? real_.count() : range_points(real_ranges_);
+}
+
+//-----------------------------------------------------------------------------
+size_t point_evaluator::predicted_points() const
+{
+  return bitsets_ ? predicted_.count() : range_points(predicted_ranges_);
+}
+
+//-----------------------------------------------------------------------------
+// Points anomalous on both sides; on ranges, a merge of the two sorted lists.
+//-----------------------------------------------------------------------------
+size_t point_evaluator::common_points() const
+{
+  if (bitsets_) return real_.count_and(predicted_);
+
+  size_t points = 0;
+  auto r = real_ranges_.begin(), p = predicted_ranges_.begin();
+  while ((r != real_ranges_.end()) && (p != predicted_ranges_.end()))
+  {
+    timestamp first = std::max(r->first, p->first);
+    timestamp last = std::min(r->second, p->second);
+    if (first <= last) points += last - first + 1;
+
+    if (r->second < p->second) ++r;
+    else ++p;
+  }
+  return points;
+}
+
+//-----------------------------------------------------------------------------
+// The predicted ranges within range, clipped to it, whatever the engine:
+// they stand for the predicted points in range, which they return the number
+// of. Predicted ranges are sorted, as read by read_file.
+//-----------------------------------------------------------------------------
+timestamp point_evaluator::predicted_overlaps(time_range range, 
+  time_intervals &out) const
+{
+  timestamp points = 0;
+  auto p = std::lower_bound(predicted_ranges_.begin(), 
+                            predicted_ranges_.end(), range.first,
+                            [](time_range const &a, timestamp t)
+                            { return a.second < t; });
+  for (; (p != predicted_ranges_.end()) && (p->first <= range.second); ++p)
+  {
+    time_range overlap(std::max(p->first, range.first),
+                       std::min(p->second, range.second));
+    out.push_back(overlap);
+    points += overlap.second - overlap.first + 1;
+  }
+  return points;
+}
+
+//-----------------------------------------------------------------------------
+// Sum of k copies of x >= 0, rounded as if they were added one at a time, as
+// evaluator adds up the equal rewards of points. While the sum stays between
+// two powers of two, every addition rounds x to the same multiple of the ulp
+// (once a first one has made the sum even in case of a tie), so the additions
+// are taken a power of two at a time.
+//-----------------------------------------------------------------------------
+static double repeated_sum(double x, u64 k)
+{
+  double sum = 0;
+  int exponent;
+
+  while (k > 0)
+  {
+    double previous = sum;
+    sum += x;
+    --k;
+
+    if ((k == 0) || (sum < DBL_MIN)) continue;
+    frexp(sum, &exponent); // 2^(exponent-1) <= sum < 2^exponent
+    if (previous < ldexp(1.0, exponent - 1)) continue;
+
+    double step = (sum + x) - sum;
+    if (step == 0) break; // x no longer changes the sum
+
+    // Room and step in ulps are integers below 2^53, so all of this is exact.
+    double ulp = ldexp(1.0, exponent - 53);
+    u64 room = (u64)((ldexp(1.0, exponent) - sum) / ulp) - 1;
+    u64 n = std::min<u64>(k, room / (u64)(step / ulp));
+    sum += (double)n * step;
+    k -= n;
+  }
+  return sum;
+}
+
+//-----------------------------------------------------------------------------
+// Reward of a point that overlaps a single point or range of the other side.
+// Its only overlap is the point itself, so it is the same for every point.
+//-----------------------------------------------------------------------------
+double point_evaluator::point_reward(e_metric m) const
+{
+  time_range point(0, 0);
+  return params_.compute_range_reward(m, point, &point, 1);
+}
+
+//-----------------------------------------------------------------------------
+// A predicted point lies in at most one real range, since real ranges are
+// disjoint. Points that lie in none have a reward of zero.
+//-----------------------------------------------------------------------------
+double point_evaluator::compute_precision() const
+{
+  size_t predicted = predicted_points();
+  if (predicted == 0) return 0.0;
+
+  return repeated_sum(point_reward(e_precision), common_points()) / predicted;
+}
+
+//-----------------------------------------------------------------------------
+double point_evaluator::compute_recall() const
+{
+  if (classical_)
+  {
+    size_t real = real_points();
+    if (real == 0) return 0.0;
+
+    return repeated_sum(point_reward(e_recall), common_points()) / real;
+  }
+
+  if (real_ranges_.size() == 0) return 0.0;
+
+  double sum = 0.0;
+  time_intervals overlaps;
+  for (auto r = real_ranges_.begin(); r != real_ranges_.end(); ++r)
+  {
+    overlaps.clear();
+    timestamp points = predicted_overlaps(*r, overlaps);
+    if (points == 0) continue; // A reward of zero
+
+    sum += params_.compute_contribution(e_recall, 
+                                        recall_terms(*r, overlaps, points))
+           .reward;
+  }
+
+  return sum / real_ranges_.size();
+}
+
+//-----------------------------------------------------------------------------
+// Omega adds up over the predicted points in a real range, in the order in
+// which evaluator adds them. A flat bias gives every point the same omega;
+// other biases take a step per point.
+//-----------------------------------------------------------------------------
+range_terms point_evaluator::recall_terms(time_range range,
+  time_intervals const &overlaps, timestamp points) const
+{
+  range_terms terms;
+  terms.overlap_count = points;
+  terms.omega_reward = 0;
+
+  if (params_.get_delta_r() == e_flat)
+  {
+    terms.omega_reward = repeated_sum(params_.compute_omega(e_recall, range,
+      time_range(range.first, range.first)), points);
+    return terms;
+  }
+
+  for (auto o = overlaps.begin(); o != overlaps.end(); ++o)
+  {
+    for (timestamp t = o->first; t <= o->second; ++t)
+    {
+      terms.omega_reward += params_.compute_omega(e_recall, range,
+                                                  time_range(t, t));
+    }
+  }
+  return terms;
+}
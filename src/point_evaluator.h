@@ -0,0 +1,153 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef POINT_EVALUATOR_H_
+#define POINT_EVALUATOR_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Anomaly labels of a series of the given size, packed 64 to a word: bit t%64
+// of word t/64 is set if position t is anomalous.
+//-----------------------------------------------------------------------------
+class label_bitset
+{
+public:
+
+  label_bitset(time_intervals const &anomalies, size_t size);
+
+  size_t size() const { return size_; }
+
+  // Number of anomalous positions, and of those also anomalous in other.
+  size_t count() const;
+  size_t count_and(label_bitset const &other) const;
+
+private:
+
+  size_t size_;
+  std::vector<unsigned long long> words_;
+};
+
+//-----------------------------------------------------------------------------
+// Evaluator for metrics where predicted anomalies are points: classical
+// metrics (-c), where real anomalies are points too, and numenta-like
+// metrics (-n), where they are ranges. Instead of unit-size ranges, points
+// are kept as bitsets:
+//
+// - Every point that overlaps the other side gets the same reward, so the
+//   classical metrics and numenta-like precision come down to counting
+//   true positives with word-wide AND and popcount.
+// - Numenta-like recall finds the predicted points inside each real range
+//   as the predicted ranges clipped to it, then adds up their omega point
+//   by point (at once for a flat bias) and counts them towards gamma.
+//
+// Bitsets take a word per 64 labels, so when the anomalies are sparse over a
+// long series (e.g., read from a range list) the same counts are taken range
+// by range instead, with time and memory proportional to the ranges.
+//
+// Rewards are added up in the same order as by evaluator on unit-size
+// ranges, as read by read_file_unitsize, so results are identical.
+//-----------------------------------------------------------------------------
+class point_evaluator
+{
+public:
+
+  // Real and predicted anomalies are ranges over a series of count labels,
+  // as read by read_file.
+  point_evaluator(time_intervals const &real, time_intervals const &predicted,
+    timestamp count, bool classical, double const beta, double const alpha_r,
+    overlap_cardinality const &gamma, positional_bias const &delta_p,
+    positional_bias const &delta_r)
+  : params_(time_intervals(), time_intervals(), beta, alpha_r, gamma, 
+            delta_p, delta_r),
+    classical_(classical), 
+    bitsets_((size_t)count / 64 < real.size() + predicted.size()),
+    real_ranges_(real), predicted_ranges_(predicted),
+    real_(bitsets_ ? real : time_intervals(), bitsets_ ? count : 0),
+    predicted_(bitsets_ ? predicted : time_intervals(), bitsets_ ? count : 0),
+    precision_(0), recall_(0), fscore_(0)
+  {
+    if (!bitsets_) check_ranges(count);
+  }
+
+  //---------------------------------------------------------------------------
+  // Getters
+  //---------------------------------------------------------------------------
+  double const & get_precision() const { return precision_; }
+  double const & get_recall() const { return recall_; }
+  double const & get_fscore() const { return fscore_; }
+
+  // Parameters live in an evaluator without any ranges of its own.
+  evaluator & get_parameters() { return params_; }
+
+  //---------------------------------------------------------------------------
+  // Updates and computers, as in evaluator
+  //---------------------------------------------------------------------------
+  void update_precision() { precision_ = compute_precision(); }
+  void update_recall() { recall_ = compute_recall(); }
+  void update_fscore() 
+  { 
+    fscore_ = params_.compute_fscore(precision_, recall_); 
+  }
+
+  double compute_precision() const;
+  double compute_recall() const;
+
+private:
+
+  double point_reward(e_metric m) const;
+  range_terms recall_terms(time_range range, time_intervals const &overlaps,
+    timestamp points) const;
+
+  void check_ranges(timestamp count) const;
+  size_t real_points() const;
+  size_t predicted_points() const;
+  size_t common_points() const;
+  timestamp predicted_overlaps(time_range range, time_intervals &out) const;
+
+  evaluator params_;
+  bool classical_;
+  bool bitsets_; // Points are counted on bitsets rather than on ranges
+
+  time_intervals real_ranges_;
+  time_intervals predicted_ranges_;
+  label_bitset real_; // Empty unless bitsets_
+  label_bitset predicted_;
+
+  double precision_;
+  double recall_;
+  double fscore_;
+};
+
+}
+
+#endif // POINT_EVALUATOR_H_
@@ -0,0 +1,293 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#include "pr_curve.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+using namespace anomaly;
+
+namespace
+{
+
+struct predicted_range
+{
+  timestamp end;
+  double reward; // Precision reward
+};
+
+typedef std::map<timestamp, predicted_range> range_map; // By start
+
+//-----------------------------------------------------------------------------
+// Incrementally maintained predicted ranges and per-range rewards.
+//-----------------------------------------------------------------------------
+class pr_sweep
+{
+public:
+
+  pr_sweep(evaluator const &params, time_intervals const &real)
+  : params_(params), real_(real), real_terms_(real.size()),
+    real_rewards_(real.size(), 0.0), real_counts_(1, 0), real_sums_(1, 0),
+    precision_sum_(0), recall_sum_(0)
+  {
+    for (auto i = real_terms_.begin(); i != real_terms_.end(); ++i)
+    {
+      i->overlap_count = 0;
+      i->omega_reward = 0;
+    }
+
+    real_counts_.reserve(real.size() + 1);
+    real_sums_.reserve(real.size() + 1);
+    for (auto r = real.begin(); r != real.end(); ++r)
+    {
+      real_counts_.push_back(real_counts_.back() + (r->second - r->first + 1));
+      real_sums_.push_back(real_sums_.back() + series_sum(r->first, r->second));
+    }
+  }
+
+  void add(timestamp t);
+
+  double precision() const
+  {
+    return predicted_.empty() ? 0.0 
+                              : (double)(precision_sum_ / predicted_.size());
+  }
+
+  double recall() const
+  {
+    return real_.empty() ? 0.0 : (double)(recall_sum_ / real_.size());
+  }
+
+private:
+
+  double predicted_reward(timestamp first, timestamp last);
+  void add_real_position(timestamp t, bool merged_left, bool merged_right);
+  void real_overlaps(timestamp first, timestamp last, size_t &begin,
+    size_t &end) const;
+  void real_positions(timestamp first, timestamp last, position_sum &count,
+    position_sum &sum) const;
+
+  evaluator const &params_;
+  time_intervals const &real_;
+  std::vector<range_terms> real_terms_;
+  std::vector<double> real_rewards_;
+  std::vector<position_sum> real_counts_; // Of real positions, by range
+  std::vector<position_sum> real_sums_;
+  range_map predicted_;
+  long double precision_sum_;
+  long double recall_sum_;
+  time_intervals overlaps_; // Scratch space
+};
+
+//-----------------------------------------------------------------------------
+// The real ranges overlapping [first, last], as indices [begin, end).
+//-----------------------------------------------------------------------------
+void pr_sweep::real_overlaps(timestamp first, timestamp last, size_t &begin,
+  size_t &end) const
+{
+  begin = std::lower_bound(real_.begin(), real_.end(), first,
+    [](time_range const &range, timestamp t) { return range.second < t; })
+    - real_.begin();
+  end = std::upper_bound(real_.begin() + begin, real_.end(), last,
+    [](timestamp t, time_range const &range) { return t < range.first; })
+    - real_.begin();
+}
+
+//-----------------------------------------------------------------------------
+// Number and sum of the real anomalous positions in [first, last], from the
+// prefix sums over the real ranges, clipped at both ends.
+//-----------------------------------------------------------------------------
+void pr_sweep::real_positions(timestamp first, timestamp last,
+  position_sum &count, position_sum &sum) const
+{
+  size_t begin, end;
+
+  count = sum = 0;
+  if (last < first) return;
+  real_overlaps(first, last, begin, end);
+  if (begin == end) return;
+
+  count = real_counts_[end] - real_counts_[begin];
+  sum = real_sums_[end] - real_sums_[begin];
+  if (real_[begin].first < first)
+  {
+    count -= first - real_[begin].first;
+    sum -= series_sum(real_[begin].first, first - 1);
+  }
+  if (real_[end - 1].second > last)
+  {
+    count -= real_[end - 1].second - last;
+    sum -= series_sum(last + 1, real_[end - 1].second);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// With a built-in positional bias, omega follows from the number and sum of
+// the overlapped positions in either half of the predicted range, so a range
+// that grows or merges costs O(log R) rather than a pass over its overlaps.
+// Plugin biases still take one omega per overlap.
+//-----------------------------------------------------------------------------
+double pr_sweep::predicted_reward(timestamp first, timestamp last)
+{
+  size_t begin, end;
+  real_overlaps(first, last, begin, end);
+
+  if (!params_.has_builtin_bias(e_precision))
+  {
+    overlaps_.clear();
+    for (size_t r = begin; r < end; ++r)
+    {
+      overlaps_.push_back(time_range(std::max(first, real_[r].first), 
+                                     std::min(last, real_[r].second)));
+    }
+    return params_.compute_range_reward(e_precision, time_range(first, last),
+                                        overlaps_.data(), overlaps_.size());
+  }
+
+  timestamp length = last - first + 1;
+  timestamp middle = first + length / 2; // First position of the upper half
+  position_moments positions;
+  real_positions(first, middle - 1, positions.lower_count,
+                 positions.lower_sum);
+  real_positions(middle, last, positions.upper_count, positions.upper_sum);
+  positions.lower_sum -= (position_sum)(first - 1) * positions.lower_count;
+  positions.upper_sum -= (position_sum)(first - 1) * positions.upper_count;
+
+  range_terms terms;
+  terms.overlap_count = end - begin;
+  terms.omega_reward = params_.compute_omega(e_precision, length, positions);
+  return params_.compute_contribution(e_precision, terms).reward;
+}
+
+//-----------------------------------------------------------------------------
+// Label t only changes the real range holding it, if any. Omega adds up over
+// positions, and the range gains an overlap unless t joined predicted ranges
+// that already overlapped it, so its terms are updated in O(1) instead of
+// rescanning the predicted ranges inside it.
+//-----------------------------------------------------------------------------
+void pr_sweep::add_real_position(timestamp t, bool merged_left,
+  bool merged_right)
+{
+  size_t r = std::lower_bound(real_.begin(), real_.end(), t,
+    [](time_range const &range, timestamp t) { return range.second < t; })
+    - real_.begin();
+  if ((r == real_.size()) || (real_[r].first > t)) return;
+
+  range_terms &terms = real_terms_[r];
+  terms.overlap_count += 1 - ((merged_left && (t > real_[r].first)) ? 1 : 0)
+                           - ((merged_right && (t < real_[r].second)) ? 1 : 0);
+  terms.omega_reward += params_.compute_omega(e_recall, real_[r],
+                                              time_range(t, t));
+
+  recall_sum_ -= real_rewards_[r];
+  real_rewards_[r] = params_.compute_contribution(e_recall, terms).reward;
+  recall_sum_ += real_rewards_[r];
+}
+
+//-----------------------------------------------------------------------------
+// Label t becomes a predicted anomaly, merging with adjacent ranges.
+//-----------------------------------------------------------------------------
+void pr_sweep::add(timestamp t)
+{
+  timestamp first = t, last = t;
+  bool merged_left = false, merged_right = false;
+
+  auto right = predicted_.find(t + 1);
+  if (right != predicted_.end())
+  {
+    last = right->second.end;
+    precision_sum_ -= right->second.reward;
+    predicted_.erase(right);
+    merged_right = true;
+  }
+
+  auto left = predicted_.lower_bound(t);
+  if ((left != predicted_.begin()) && (std::prev(left)->second.end == t - 1))
+  {
+    --left;
+    first = left->first;
+    precision_sum_ -= left->second.reward;
+    predicted_.erase(left);
+    merged_left = true;
+  }
+
+  predicted_range range;
+  range.end = last;
+  range.reward = predicted_reward(first, last);
+  predicted_[first] = range;
+  precision_sum_ += range.reward;
+
+  add_real_position(t, merged_left, merged_right);
+}
+
+}
+
+//-----------------------------------------------------------------------------
+std::vector<pr_point> anomaly::compute_pr_curve(evaluator const &params,
+  time_intervals const &real, std::vector<double> const &scores)
+{
+  std::vector<timestamp> order(scores.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+    [&](timestamp a, timestamp b) { return scores[a] > scores[b]; });
+
+  pr_sweep sweep(params, real);
+  std::vector<pr_point> curve;
+
+  for (size_t i = 0; i < order.size(); )
+  {
+    double threshold = scores[order[i]];
+    for (; (i < order.size()) && (scores[order[i]] == threshold); ++i)
+      sweep.add(order[i]);
+
+    pr_point point;
+    point.threshold = threshold;
+    point.precision = sweep.precision();
+    point.recall = sweep.recall();
+    point.fscore = params.compute_fscore(point.precision, point.recall);
+    curve.push_back(point);
+  }
+
+  return curve;
+}
+
+//-----------------------------------------------------------------------------
+double anomaly::compute_pr_auc(std::vector<pr_point> const &curve)
+{
+  double auc = 0.0;
+  double recall = 0.0;
+  double precision = curve.empty() ? 0.0 : curve.front().precision;
+
+  for (auto p = curve.begin(); p != curve.end(); ++p)
+  {
+    auc += (p->recall - recall) * (p->precision + precision) / 2;
+    recall = p->recall;
+    precision = p->precision;
+  }
+
+  return auc;
+}
@@ -0,0 +1,69 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#ifndef PR_CURVE_H_
+#define PR_CURVE_H_
+
+#include <string>
+#include <vector>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+struct pr_point
+{
+  double threshold; // Labels with score >= threshold are predicted anomalies
+  double precision;
+  double recall;
+  double fscore;
+};
+
+//-----------------------------------------------------------------------------
+// Range-based precision/recall for every distinct threshold of the anomaly
+// scores, from the highest threshold to the lowest. The parameters (beta,
+// alpha_r, gamma, deltas) are taken from the given evaluator, whose own
+// ranges are not used. The real anomaly ranges must be sorted and disjoint.
+//
+// Lowering the threshold turns labels into predicted anomalies one by one,
+// each of which creates, extends or merges predicted ranges. Only the reward
+// of the predicted range that changed is recomputed, in O(log R) from prefix
+// sums over the real ranges for the built-in positional biases; the real
+// range holding the label keeps its overlap count and omega sum up to date.
+// Running sums are kept in extended precision and omega of a predicted range
+// is rounded once, so values may differ from a separate evaluation in the
+// last digits.
+//-----------------------------------------------------------------------------
+std::vector<pr_point> compute_pr_curve(evaluator const &params,
+  time_intervals const &real, std::vector<double> const &scores);
+
+// Area under the curve (recall on the x axis), by the trapezoidal rule,
+// starting from recall 0 at the precision of the highest threshold.
+double compute_pr_auc(std::vector<pr_point> const &curve);
+
+}
+
+#endif // PR_CURVE_H_
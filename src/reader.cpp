@@ -0,0 +1,641 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#include "reader.h"
+#include "decompress.h"
+#include "interval_file.h"
+#include "stats.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace anomaly;
+
+static inline bool is_space(char c)
+{
+  return (c == ' ') || ((c >= '\t') && (c <= '\r'));
+}
+
+//-----------------------------------------------------------------------------
+void label_parser::add_label(int label)
+{
+  if (label == 1) // Anomaly.
+  {
+    if (unitsize_)
+    {
+      anomalies_.push_back(time_range(count_, count_));
+    }
+    else if (!range_started_)
+    {
+      range_started_ = true;
+      range_.first = count_;
+      range_.second = count_;
+    }
+    else range_.second = count_;
+  }
+  else if (label == 0) // Not anomaly.
+  {
+    if (range_started_)
+    {
+      anomalies_.push_back(range_);
+      range_started_ = false;
+    }
+  }
+  else
+  {
+    throw "Error: Invalid anomaly label!";
+  }
+
+  ++count_;
+}
+
+//-----------------------------------------------------------------------------
+// Adds n labels at once, where bit 2k of "ones" is set iff label k is 1.
+//-----------------------------------------------------------------------------
+void label_parser::add_block(unsigned ones, int n)
+{
+  if ((ones == 0) && !range_started_) // Common case: no anomalies at all.
+  {
+    count_ += n;
+    return;
+  }
+  if ((ones == (0x5555u & ((1u << (2 * n)) - 1))) && range_started_ && 
+      !unitsize_) // Common case: inside a long anomaly.
+  {
+    count_ += n;
+    range_.second = count_ - 1;
+    return;
+  }
+
+  for (int k = 0; k < n; ++k) add_label((ones >> (2 * k)) & 1);
+}
+
+//-----------------------------------------------------------------------------
+// Vectorized scan of the dominant "d\n" layout, 8 labels per 16 bytes.
+// Returns the number of bytes consumed; stops at the first block that does
+// not match the layout, leaving it to the general state machine.
+//-----------------------------------------------------------------------------
+size_t label_parser::feed_fast(char const *data, size_t size)
+{
+  size_t pos = 0;
+
+#if defined(__SSE2__)
+  __m128i const newline = _mm_set1_epi8('\n');
+  __m128i const one = _mm_set1_epi8('1');
+  __m128i const low_bit = _mm_set1_epi8(1);
+
+  while (pos + 16 <= size)
+  {
+    __m128i v = _mm_loadu_si128((__m128i const *)(data + pos));
+    unsigned newlines = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+    unsigned digits = _mm_movemask_epi8(
+                        _mm_cmpeq_epi8(_mm_or_si128(v, low_bit), one));
+
+    if (((newlines & 0xAAAAu) != 0xAAAAu) || ((digits & 0x5555u) != 0x5555u))
+      break;
+
+    add_block(_mm_movemask_epi8(_mm_cmpeq_epi8(v, one)) & 0x5555u, 8);
+    pos += 16;
+  }
+#endif
+
+  while ((pos + 2 <= size) && (data[pos + 1] == '\n') &&
+         ((data[pos] | 1) == '1'))
+  {
+    add_label(data[pos] - '0');
+    pos += 2;
+  }
+
+  return pos;
+}
+
+//-----------------------------------------------------------------------------
+void label_parser::feed(char const *data, size_t size)
+{
+  size_t pos = 0;
+
+  while (pos < size)
+  {
+    switch (state_)
+    {
+      case s_skip_space:
+        pos += feed_fast(data + pos, size - pos);
+        if (pos == size) break;
+        if (is_space(data[pos])) ++pos;
+        else state_ = s_sign;
+        break;
+
+      case s_sign:
+        negative_ = (data[pos] == '-');
+        if ((data[pos] == '-') || (data[pos] == '+')) ++pos;
+        value_ = 0;
+        digits_ = 0;
+        state_ = s_digits;
+        break;
+
+      case s_digits:
+        if ((data[pos] >= '0') && (data[pos] <= '9'))
+        {
+          value_ = value_ * 10 + (data[pos] - '0');
+          ++digits_;
+          if (value_ > INT_MAX) state_ = s_failed; // Out of int range.
+          else ++pos;
+        }
+        else if (digits_ == 0)
+        {
+          state_ = s_failed; // Sign without digits, or not a number.
+        }
+        else
+        {
+          add_label(negative_ ? -(int)value_ : (int)value_);
+          state_ = s_skip_line;
+        }
+        break;
+
+      case s_skip_line:
+        while ((pos < size) && (data[pos] != '\n')) ++pos;
+        if (pos < size)
+        {
+          ++pos;
+          state_ = s_skip_space;
+        }
+        break;
+
+      case s_failed:
+        return; // Like a failed stream, ignore everything else.
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+time_intervals & label_parser::finish(timestamp &count)
+{
+  // Last label, not followed by a newline.
+  if ((state_ == s_digits) && (digits_ > 0))
+  {
+    add_label(negative_ ? -(int)value_ : (int)value_);
+    state_ = s_skip_line;
+  }
+
+  if (range_started_) // Last read label was an anomaly.
+  {
+    anomalies_.push_back(range_);
+    range_started_ = false;
+  }
+
+  count = count_;
+  return anomalies_;
+}
+
+//-----------------------------------------------------------------------------
+static ssize_t read_some(int fd, char *buffer, size_t size)
+{
+  ssize_t n;
+  while (((n = read(fd, buffer, size)) < 0) && (errno == EINTR)) {}
+  if (n < 0) throw "Error: Could not read file!";
+  return n;
+}
+
+static time_intervals load_stream(decompressor::byte_source const &read_more,
+  bool unitsize, timestamp &count, bool decompressed);
+
+//-----------------------------------------------------------------------------
+// Reads a compressed file from the decompressor of its contents.
+//-----------------------------------------------------------------------------
+static time_intervals load_compressed(decompressor &input, bool unitsize, 
+  timestamp &count)
+{
+  return load_stream([&input](char *buffer, size_t size)
+                     { return input.read(buffer, size); }, 
+                     unitsize, count, true);
+}
+
+//-----------------------------------------------------------------------------
+// Decodes a label, interval or range list file held in memory, decompressing
+// it on the fly if it is compressed.
+//-----------------------------------------------------------------------------
+static time_intervals load_buffer(char const *data, size_t size,
+  bool unitsize, timestamp &count)
+{
+  if (detect_compression(data, size) != e_uncompressed)
+  {
+    decompressor input(data, size);
+    return load_compressed(input, unitsize, count);
+  }
+
+  if (is_interval_file(data, size))
+    return decode_interval_file(data, size, unitsize, count);
+  if (is_range_list(data, size))
+    return decode_range_list(data, size, unitsize, count);
+
+  label_parser parser(unitsize);
+  parser.feed(data, size);
+
+  time_intervals anomalies;
+  anomalies.swap(parser.finish(count));
+  return anomalies;
+}
+
+//-----------------------------------------------------------------------------
+// Streams a label, interval or range list file that cannot be mapped, or the
+// contents of a compressed file (decompressed), from read_more. Label files
+// are parsed chunk by chunk; interval files and range lists are small and
+// read whole. Compressed files are passed on to a decompressor.
+//-----------------------------------------------------------------------------
+static time_intervals load_stream(decompressor::byte_source const &read_more,
+  bool unitsize, timestamp &count, bool decompressed)
+{
+  std::vector<char> buffer(1 << 20);
+  size_t head = 0;
+  size_t n = 1;
+
+  while ((head < sizeof(interval_file_magic)) &&
+         ((n = read_more(&buffer[head], buffer.size() - head)) > 0))
+    head += n;
+
+  if (!decompressed && 
+      (detect_compression(&buffer[0], head) != e_uncompressed))
+  {
+    decompressor input(std::vector<char>(buffer.begin(), 
+                                         buffer.begin() + head), read_more);
+    return load_compressed(input, unitsize, count);
+  }
+
+  bool intervals = is_interval_file(&buffer[0], head);
+  if (intervals || is_range_list(&buffer[0], head))
+  {
+    buffer.resize(head);
+    char chunk[1 << 16];
+    while ((n = read_more(chunk, sizeof(chunk))) > 0)
+      buffer.insert(buffer.end(), chunk, chunk + n);
+    return intervals 
+           ? decode_interval_file(&buffer[0], buffer.size(), unitsize, count)
+           : decode_range_list(&buffer[0], buffer.size(), unitsize, count);
+  }
+
+  label_parser parser(unitsize);
+  parser.feed(&buffer[0], head);
+  while ((n > 0) && ((n = read_more(&buffer[0], buffer.size())) > 0))
+    parser.feed(&buffer[0], n);
+
+  time_intervals anomalies;
+  anomalies.swap(parser.finish(count));
+  return anomalies;
+}
+
+//-----------------------------------------------------------------------------
+// Loads a whole file: mapped in one go if it is a regular file, streamed
+// otherwise. The format (labels, intervals or ranges) is detected from its
+// content.
+//-----------------------------------------------------------------------------
+static time_intervals load_file(std::string const &path, bool unitsize,
+  timestamp &count)
+{
+  int fd = (path == "-") ? STDIN_FILENO : open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw "Error: Could not open file!";
+
+  time_intervals anomalies;
+  try
+  {
+    struct stat info;
+    if ((fstat(fd, &info) == 0) && S_ISREG(info.st_mode) && 
+        (info.st_size > 0))
+    {
+      void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) throw "Error: Could not read file!";
+      madvise(data, info.st_size, MADV_SEQUENTIAL);
+      TSAD_COUNT(c_bytes_read, info.st_size);
+
+      try
+      {
+        anomalies = load_buffer((char const *)data, info.st_size, 
+                                unitsize, count);
+      }
+      catch (...)
+      {
+        munmap(data, info.st_size);
+        throw;
+      }
+      munmap(data, info.st_size);
+    }
+    else
+    {
+      anomalies = load_stream([fd](char *buffer, size_t size)
+                              {
+                                ssize_t n = read_some(fd, buffer, size);
+                                TSAD_COUNT(c_bytes_read, n);
+                                return (size_t)n;
+                              }, unitsize, count, false);
+    }
+  }
+  catch (...)
+  {
+    if (fd != STDIN_FILENO) close(fd);
+    throw;
+  }
+  if (fd != STDIN_FILENO) close(fd);
+
+  return anomalies;
+}
+
+//-----------------------------------------------------------------------------
+time_intervals anomaly::read_file(std::string const &path, timestamp &count)
+{
+  return load_file(path, false, count);
+}
+
+//-----------------------------------------------------------------------------
+time_intervals anomaly::read_file_unitsize(std::string const &path,
+  timestamp &count)
+{
+  return load_file(path, true, count);
+}
+
+//-----------------------------------------------------------------------------
+// Anomaly ranges of all channels in a block of lines of a multi-column file,
+// with line numbers relative to the block. Ranges still open at the end of
+// the block end at its last line and are joined with the next block later.
+//-----------------------------------------------------------------------------
+struct column_block
+{
+  timestamp lines;
+  std::vector<time_intervals> anomalies;
+};
+
+static inline bool is_column_separator(char c)
+{
+  return (c == ' ') || (c == '\t') || (c == '\r') || (c == ',');
+}
+
+//-----------------------------------------------------------------------------
+// Calls label(column, value) for every column of a line and returns the
+// number of columns; 0 for a blank line.
+//-----------------------------------------------------------------------------
+template <typename Label>
+static size_t parse_line(char const *line, char const *end, Label label)
+{
+  size_t column = 0;
+  char const *p = line;
+
+  while (true)
+  {
+    while ((p < end) && is_column_separator(*p)) ++p;
+    if (p == end) return column;
+
+    char const *token = p;
+    while ((p < end) && !is_column_separator(*p)) ++p;
+    if ((p - token != 1) || ((*token != '0') && (*token != '1')))
+      throw "Error: Invalid anomaly label!";
+
+    label(column++, *token - '0');
+  }
+}
+
+//-----------------------------------------------------------------------------
+static void parse_columns(char const *data, size_t size, size_t columns,
+  column_block &block)
+{
+  std::vector<timestamp> started(columns, -1); // Start of an open range
+  block.anomalies.assign(columns, time_intervals());
+  block.lines = 0;
+
+  char const *end = data + size;
+  for (char const *line = data; line < end; )
+  {
+    char const *eol = (char const *)memchr(line, '\n', end - line);
+    if (eol == NULL) eol = end;
+
+    timestamp t = block.lines;
+    size_t n = parse_line(line, eol, [&](size_t c, int label)
+    {
+      if (c >= columns) return;
+      if (label == 1)
+      {
+        if (started[c] < 0) started[c] = t;
+      }
+      else if (started[c] >= 0)
+      {
+        block.anomalies[c].push_back(time_range(started[c], t - 1));
+        started[c] = -1;
+      }
+    });
+
+    if (n != 0)
+    {
+      if (n != columns) throw "Error: Inconsistent number of columns!";
+      if (block.lines == LLONG_MAX) throw "Error: Too many data items!";
+      ++block.lines;
+    }
+    line = eol + 1;
+  }
+
+  for (size_t c = 0; c < columns; ++c)
+  {
+    if (started[c] >= 0)
+      block.anomalies[c].push_back(time_range(started[c], block.lines - 1));
+  }
+}
+
+//-----------------------------------------------------------------------------
+static std::vector<time_intervals> decode_columns(char const *data,
+  size_t size, unsigned threads, timestamp &count)
+{
+  char const *end = data + size;
+  size_t columns = 0;
+  for (char const *line = data; (line < end) && (columns == 0); )
+  {
+    char const *eol = (char const *)memchr(line, '\n', end - line);
+    if (eol == NULL) eol = end;
+    columns = parse_line(line, eol, [](size_t, int) {});
+    line = eol + 1;
+  }
+
+  // Blocks of lines, each large enough to be worth a thread of its own.
+  size_t const min_block = 1 << 20;
+  size_t blocks = std::max<size_t>(1, std::min<size_t>(threads, 
+                                                       size / min_block));
+  std::vector<size_t> bounds(1, 0);
+  for (size_t b = 1; b < blocks; ++b)
+  {
+    char const *p = data + std::max(bounds.back(), b * size / blocks);
+    char const *eol = (char const *)memchr(p, '\n', end - p);
+    if (eol == NULL) break;
+    bounds.push_back(eol + 1 - data);
+  }
+  bounds.push_back(size);
+
+  std::vector<column_block> parsed(bounds.size() - 1);
+  if (parsed.size() == 1) parse_columns(data, size, columns, parsed[0]);
+  else
+  {
+    thread_pool pool(parsed.size());
+    for (size_t b = 0; b < parsed.size(); ++b)
+    {
+      pool.submit([&, b]
+      {
+        parse_columns(data + bounds[b], bounds[b + 1] - bounds[b], columns,
+                      parsed[b]);
+      });
+    }
+    pool.wait();
+  }
+
+  // Shift the ranges of every block by the lines before it, joining ranges
+  // that run across block boundaries.
+  std::vector<time_intervals> anomalies(columns);
+  timestamp offset = 0;
+  for (size_t b = 0; b < parsed.size(); ++b)
+  {
+    for (size_t c = 0; c < columns; ++c)
+    {
+      time_intervals &to = anomalies[c];
+      time_intervals const &from = parsed[b].anomalies[c];
+      auto r = from.begin();
+      if ((r != from.end()) && (r->first == 0) && !to.empty() &&
+          (to.back().second == offset - 1))
+      {
+        to.back().second = offset + r->second;
+        ++r;
+      }
+      for (; r != from.end(); ++r)
+        to.push_back(time_range(offset + r->first, offset + r->second));
+    }
+    if (parsed[b].lines > LLONG_MAX - offset) 
+      throw "Error: Too many data items!";
+    offset += parsed[b].lines;
+  }
+
+  count = offset;
+  return anomalies;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<time_intervals> anomaly::read_columns(std::string const &path,
+  unsigned threads, timestamp &count)
+{
+  int fd = (path == "-") ? STDIN_FILENO : open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw "Error: Could not open file!";
+
+  std::vector<time_intervals> anomalies;
+  try
+  {
+    struct stat info;
+    if ((fstat(fd, &info) == 0) && S_ISREG(info.st_mode) && 
+        (info.st_size > 0))
+    {
+      void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) throw "Error: Could not read file!";
+      TSAD_COUNT(c_bytes_read, info.st_size);
+
+      try
+      {
+        anomalies = decode_columns((char const *)data, info.st_size, 
+                                   threads, count);
+      }
+      catch (...)
+      {
+        munmap(data, info.st_size);
+        throw;
+      }
+      munmap(data, info.st_size);
+    }
+    else
+    {
+      std::vector<char> buffer;
+      char chunk[1 << 16];
+      ssize_t n;
+      while ((n = read_some(fd, chunk, sizeof(chunk))) > 0)
+      {
+        TSAD_COUNT(c_bytes_read, n);
+        buffer.insert(buffer.end(), chunk, chunk + n);
+      }
+      anomalies = decode_columns(buffer.data(), buffer.size(), threads, 
+                                 count);
+    }
+  }
+  catch (...)
+  {
+    if (fd != STDIN_FILENO) close(fd);
+    throw;
+  }
+  if (fd != STDIN_FILENO) close(fd);
+
+  return anomalies;
+}
+
+//-----------------------------------------------------------------------------
+void anomaly::read_labels(unsigned char const *labels, size_t length,
+  bool unitsize, time_intervals &anomalies)
+{
+  if (length > (size_t)LLONG_MAX) throw "Error: Too many data items!";
+
+  anomalies.clear();
+  timestamp n = (timestamp)length;
+  for (timestamp i = 0; i < n; ++i)
+  {
+    if (labels[i] == 0) continue;
+
+    timestamp start = i;
+    if (!unitsize) while ((i + 1 < n) && (labels[i + 1] != 0)) ++i;
+    anomalies.push_back(time_range(start, i));
+  }
+}
+
+//-----------------------------------------------------------------------------
+std::vector<double> anomaly::read_scores(std::string const &path)
+{
+  std::ifstream file;
+  if (path != "-")
+  {
+    file.open(path.c_str());
+    if (!file.is_open()) throw "Error: Could not open file!";
+  }
+  std::istream &data = (path == "-") ? std::cin : file;
+
+  std::vector<double> scores;
+  double score;
+  while (data >> score)
+  {
+    data.ignore(INT_MAX, '\n'); // Ignore everything else other than score.
+    if (std::isnan(score)) throw "Error: Invalid anomaly score!";
+    scores.push_back(score);
+  }
+
+  return scores;
+}
@@ -0,0 +1,114 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#ifndef READER_H_
+#define READER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Incremental parser for files of 0/1 anomaly labels. Input can be fed in
+// chunks of any size (chunk boundaries may fall anywhere, even inside a
+// label), and each line contributes its first integer, exactly like reading
+// the file with "ifstream >> int" followed by ignoring the rest of the line:
+// leading whitespace and blank lines are skipped, and parsing stops silently
+// at the first token that is not an integer.
+//-----------------------------------------------------------------------------
+class label_parser
+{
+public:
+
+  explicit label_parser(bool unitsize)
+  : unitsize_(unitsize), state_(s_skip_space), negative_(false), value_(0),
+    digits_(0), count_(0), range_started_(false)
+  {}
+
+  void feed(char const *data, size_t size);
+  time_intervals & finish(timestamp &count);
+
+private:
+
+  typedef enum {s_skip_space, s_sign, s_digits, s_skip_line, s_failed} state;
+
+  size_t feed_fast(char const *data, size_t size);
+  void add_label(int label);
+  void add_block(unsigned ones, int n);
+
+  bool unitsize_; // Emit one unit-size range per anomalous label
+
+  state state_;
+  bool negative_;
+  long long value_;
+  int digits_;
+
+  timestamp count_; // Number of labels read so far
+  bool range_started_;
+  time_range range_;
+  time_intervals anomalies_;
+};
+
+//-----------------------------------------------------------------------------
+// Read a label file into anomaly ranges (or unit-size ranges) and count its
+// labels. Interval files and range lists (see interval_file.h) are
+// recognized by their first bytes and accepted as well. Regular files are
+// memory-mapped, anything else (pipes, devices, or "-" for stdin) is read
+// through a buffer.
+//-----------------------------------------------------------------------------
+time_intervals read_file(std::string const &path, timestamp &count);
+time_intervals read_file_unitsize(std::string const &path, timestamp &count);
+
+//-----------------------------------------------------------------------------
+// Read a file with a column of 0/1 labels per channel into the anomaly ranges
+// of every channel, in one pass, and count its lines. Columns are separated
+// by whitespace or commas, and all lines must have as many columns as the
+// first. Large files are parsed by up to "threads" threads, each on a block
+// of lines.
+//-----------------------------------------------------------------------------
+std::vector<time_intervals> read_columns(std::string const &path,
+  unsigned threads, timestamp &count);
+
+//-----------------------------------------------------------------------------
+// Convert a buffer of labels in memory (nonzero for anomalies) into anomaly
+// ranges (or unit-size ranges). The ranges replace the contents of
+// anomalies, whose capacity is reused.
+//-----------------------------------------------------------------------------
+void read_labels(unsigned char const *labels, size_t length, bool unitsize,
+  time_intervals &anomalies);
+
+//-----------------------------------------------------------------------------
+// Read a file of real-valued anomaly scores, one per line ("-" for stdin).
+//-----------------------------------------------------------------------------
+std::vector<double> read_scores(std::string const &path);
+
+}
+
+#endif // READER_H_
@@ -0,0 +1,653 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "result_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "interval_file.h"
+#include "reader.h"
+
+using namespace anomaly;
+
+typedef unsigned long long u64;
+
+static const char result_file_magic[4] = {'T', 'S', 'A', 'C'};
+static const unsigned result_file_version = 1;
+
+//-----------------------------------------------------------------------------
+// XXH64
+//-----------------------------------------------------------------------------
+static const u64 prime1 = 11400714785074694791ULL;
+static const u64 prime2 = 14029467366897019727ULL;
+static const u64 prime3 = 1609587929392839161ULL;
+static const u64 prime4 = 9650029242287828579ULL;
+static const u64 prime5 = 2870177450012600261ULL;
+
+static inline u64 rotl(u64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static inline u64 read64(unsigned char const *p)
+{
+  u64 value = 0;
+  for (int i = 7; i >= 0; --i) value = (value << 8) | p[i];
+  return value;
+}
+
+static inline u64 read32(unsigned char const *p)
+{
+  return ((u64)p[3] << 24) | ((u64)p[2] << 16) | ((u64)p[1] << 8) | p[0];
+}
+
+static inline u64 hash_round(u64 acc, u64 input)
+{
+  return rotl(acc + input * prime2, 31) * prime1;
+}
+
+static inline u64 merge_round(u64 acc, u64 value)
+{
+  return (acc ^ hash_round(0, value)) * prime1 + prime4;
+}
+
+//-----------------------------------------------------------------------------
+u64 anomaly::hash_bytes(void const *data, size_t size, u64 seed)
+{
+  unsigned char const *p = (unsigned char const *)data;
+  unsigned char const *end = p + size;
+  u64 h;
+
+  if (size >= 32)
+  {
+    u64 v1 = seed + prime1 + prime2, v2 = seed + prime2;
+    u64 v3 = seed, v4 = seed - prime1;
+    for (; p + 32 <= end; p += 32)
+    {
+      v1 = hash_round(v1, read64(p));
+      v2 = hash_round(v2, read64(p + 8));
+      v3 = hash_round(v3, read64(p + 16));
+      v4 = hash_round(v4, read64(p + 24));
+    }
+    h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    h = merge_round(h, v1);
+    h = merge_round(h, v2);
+    h = merge_round(h, v3);
+    h = merge_round(h, v4);
+  }
+  else h = seed + prime5;
+
+  h += size;
+  for (; p + 8 <= end; p += 8)
+    h = rotl(h ^ hash_round(0, read64(p)), 27) * prime1 + prime4;
+  if (p + 4 <= end)
+  {
+    h = rotl(h ^ (read32(p) * prime1), 23) * prime2 + prime3;
+    p += 4;
+  }
+  for (; p < end; ++p) h = rotl(h ^ (*p * prime5), 11) * prime1;
+
+  h ^= h >> 33;
+  h *= prime2;
+  h ^= h >> 29;
+  h *= prime3;
+  h ^= h >> 32;
+  return h;
+}
+
+//-----------------------------------------------------------------------------
+static long long modified(struct stat const &info)
+{
+  return info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+}
+
+//-----------------------------------------------------------------------------
+// Hashes a regular file in place, memory-mapped. Files that cannot be opened
+// have no digest either; reading them reports the error.
+//-----------------------------------------------------------------------------
+bool anomaly::digest_file(std::string const &path, file_digest &digest)
+{
+  if (path == "-") return false;
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat info;
+  bool ok = (fstat(fd, &info) == 0) && S_ISREG(info.st_mode);
+  if (ok)
+  {
+    digest.size = info.st_size;
+    digest.modified = modified(info);
+    digest.ranges = false;
+    digest.hash = hash_bytes(NULL, 0);
+    if (info.st_size > 0)
+    {
+      void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) ok = false;
+      else
+      {
+        madvise(data, info.st_size, MADV_SEQUENTIAL);
+        digest.hash = hash_bytes(data, info.st_size);
+        digest.ranges = is_interval_file((char const *)data, info.st_size) ||
+                        is_range_list((char const *)data, info.st_size);
+        munmap(data, info.st_size);
+      }
+    }
+  }
+  close(fd);
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+static void put_le(std::vector<char> &out, u64 value, int bytes)
+{
+  for (int i = 0; i < bytes; ++i, value >>= 8) out.push_back((char)value);
+}
+
+static void put_double(std::vector<char> &out, double value)
+{
+  u64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  put_le(out, bits, 8);
+}
+
+//-----------------------------------------------------------------------------
+// Sequential decoding of an entry; running past its end fails.
+//-----------------------------------------------------------------------------
+class entry_reader
+{
+public:
+
+  entry_reader(std::vector<char> const &data)
+  : pos_(data.data()), end_(data.data() + data.size()), ok_(true)
+  {}
+
+  bool ok() const { return ok_; }
+  bool at_end() const { return pos_ == end_; }
+
+  char const * get(size_t size)
+  {
+    if ((size_t)(end_ - pos_) < size)
+    {
+      ok_ = false;
+      return NULL;
+    }
+    char const *at = pos_;
+    pos_ += size;
+    return at;
+  }
+
+  u64 get_le(int bytes)
+  {
+    unsigned char const *p = (unsigned char const *)get(bytes);
+    u64 value = 0;
+    for (int i = bytes - 1; p && (i >= 0); --i) value = (value << 8) | p[i];
+    return value;
+  }
+
+  double get_double()
+  {
+    u64 bits = get_le(8);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+private:
+
+  char const *pos_;
+  char const *end_;
+  bool ok_;
+};
+
+//-----------------------------------------------------------------------------
+static std::string hex(u64 value)
+{
+  char text[17];
+  snprintf(text, sizeof(text), "%016llx", value);
+  return text;
+}
+
+//-----------------------------------------------------------------------------
+static bool read_whole(std::string const &path, std::vector<char> &data)
+{
+  FILE *file = fopen(path.c_str(), "rb");
+  if (file == NULL) return false;
+
+  data.clear();
+  char chunk[1 << 16];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    data.insert(data.end(), chunk, chunk + n);
+  bool ok = !ferror(file);
+  fclose(file);
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+// Marks an entry as recently used.
+//-----------------------------------------------------------------------------
+static void touch(std::string const &path)
+{
+  utimensat(AT_FDCWD, path.c_str(), NULL, 0);
+}
+
+//-----------------------------------------------------------------------------
+// Identity of the running binary, part of every result key.
+//-----------------------------------------------------------------------------
+static std::string binary_identity()
+{
+  struct stat info;
+  if (stat("/proc/self/exe", &info) != 0) return std::string();
+
+  std::vector<char> identity;
+  put_le(identity, info.st_dev, 8);
+  put_le(identity, info.st_ino, 8);
+  put_le(identity, info.st_size, 8);
+  put_le(identity, modified(info), 8);
+  return std::string(identity.begin(), identity.end());
+}
+
+//-----------------------------------------------------------------------------
+// Identity of a file for the digests memo: device, inode, size, and the
+// modification and status change times.
+//-----------------------------------------------------------------------------
+static std::string file_id(struct stat const &info)
+{
+  std::vector<char> id;
+  put_le(id, info.st_dev, 8);
+  put_le(id, info.st_ino, 8);
+  put_le(id, info.st_size, 8);
+  put_le(id, modified(info), 8);
+  put_le(id, info.st_ctim.tv_sec * 1000000000LL + info.st_ctim.tv_nsec, 8);
+  return std::string(id.begin(), id.end());
+}
+
+//-----------------------------------------------------------------------------
+void result_cache::open(std::string const &dir, u64 limit)
+{
+  std::string const dirs[] = {dir, dir + "/results", dir + "/intervals",
+                              dir + "/digests"};
+  for (int i = 0; i < 4; ++i)
+  {
+    if ((mkdir(dirs[i].c_str(), 0777) != 0) && (errno != EEXIST))
+      throw "Error: Could not create cache directory!";
+  }
+  dir_ = dir;
+  limit_ = limit;
+}
+
+//-----------------------------------------------------------------------------
+// Digests a data file, unless a file of the same id was digested before.
+// Files changed in the last two seconds are hashed every time: within the
+// resolution of their times, a later change would keep the same id.
+// Digest entries hold the file id (40 bytes), the hash (8 bytes) and the
+// ranges flag (1 byte).
+//-----------------------------------------------------------------------------
+bool result_cache::find_digest(std::string const &path, 
+  file_digest &digest)
+{
+  struct stat info;
+  if ((path == "-") || (stat(path.c_str(), &info) != 0) ||
+      !S_ISREG(info.st_mode))
+    return false;
+
+  std::string id = file_id(info);
+  auto memo = digests_.find(id);
+  if (memo != digests_.end())
+  {
+    digest = memo->second;
+    return true;
+  }
+
+  std::string entry = dir_ + "/digests/" + hex(hash_bytes(id.data(), 
+                                                          id.size()));
+  std::vector<char> data;
+  if (read_whole(entry, data))
+  {
+    entry_reader in(data);
+    char const *stored_id = in.get(id.size());
+    digest.hash = in.get_le(8);
+    digest.ranges = (in.get_le(1) != 0);
+    digest.size = info.st_size;
+    digest.modified = modified(info);
+    if (in.ok() && in.at_end() && 
+        (memcmp(stored_id, id.data(), id.size()) == 0))
+    {
+      touch(entry);
+      digests_[id] = digest;
+      return true;
+    }
+  }
+
+  if (!digest_file(path, digest)) return false;
+
+  // Only remembered if the file did not change while it was hashed.
+  struct stat after;
+  if ((stat(path.c_str(), &after) != 0) || (file_id(after) != id))
+    return true;
+  digests_[id] = digest;
+
+  long long const settled = (time(NULL) - 2) * 1000000000LL;
+  if ((modified(info) < settled) && 
+      (info.st_ctim.tv_sec * 1000000000LL + info.st_ctim.tv_nsec < settled))
+  {
+    data.assign(id.begin(), id.end());
+    put_le(data, digest.hash, 8);
+    put_le(data, digest.ranges, 1);
+    store(entry, data);
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+time_intervals result_cache::read_file(std::string const &path,
+  bool unitsize, timestamp &count)
+{
+  file_digest digest;
+  if (!is_open() || !find_digest(path, digest) || digest.ranges)
+  {
+    return unitsize ? read_file_unitsize(path, count)
+                    : anomaly::read_file(path, count);
+  }
+
+  std::string entry = dir_ + "/intervals/" + hex(digest.hash) + 
+                      hex(digest.size);
+  std::vector<char> data;
+  if (read_whole(entry, data))
+  {
+    try
+    {
+      time_intervals anomalies = decode_interval_file(data.data(), 
+                                   data.size(), unitsize, count);
+      touch(entry);
+      return anomalies;
+    }
+    catch (const char *)
+    {
+      unlink(entry.c_str()); // Corrupt; parsed again below.
+    }
+  }
+
+  time_intervals anomalies = anomaly::read_file(path, count);
+
+  // Only stored if the file did not change while it was parsed.
+  struct stat info;
+  if ((stat(path.c_str(), &info) == 0) && 
+      ((u64)info.st_size == digest.size) && 
+      (modified(info) == digest.modified))
+    store(entry, encode_interval_file(anomalies, count, true));
+
+  if (unitsize)
+  {
+    time_intervals points;
+    for (auto r = anomalies.begin(); r != anomalies.end(); ++r)
+    {
+      for (timestamp t = r->first; t <= r->second; ++t)
+        points.push_back(time_range(t, t));
+    }
+    anomalies.swap(points);
+  }
+  return anomalies;
+}
+
+//-----------------------------------------------------------------------------
+bool result_cache::make_key(evaluation_job const &job, std::string &key)
+{
+  static std::string const binary = binary_identity();
+
+  file_digest real, predicted;
+  if (!is_open() || binary.empty() || !job.gamma_udf.empty() || 
+      !job.delta_p_udf.empty() || !job.delta_r_udf.empty() ||
+      !find_digest(job.real_file, real) || 
+      !find_digest(job.predicted_file, predicted))
+    return false;
+
+  std::vector<char> material(binary.begin(), binary.end());
+  put_le(material, real.hash, 8);
+  put_le(material, real.size, 8);
+  put_le(material, predicted.hash, 8);
+  put_le(material, predicted.size, 8);
+  material.insert(material.end(), job.metric_option.begin(), 
+                  job.metric_option.end());
+  put_double(material, job.beta);
+  put_double(material, job.alpha_r);
+  put_le(material, job.gamma, 1);
+  put_le(material, job.delta_p, 1);
+  put_le(material, job.delta_r, 1);
+
+  key.assign(material.begin(), material.end());
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Result entries hold their full key, which must match, and the metrics:
+// precision, recall and F-Score (float64), the number of NAB scores (4
+// bytes), and each score's raw and normalized values (float64) and true
+// positive, false positive and false negative counts (8 bytes each).
+//-----------------------------------------------------------------------------
+bool result_cache::find_result(std::string const &key,
+  evaluation_result &result)
+{
+  std::string entry = dir_ + "/results/" + 
+                      hex(hash_bytes(key.data(), key.size()));
+  std::vector<char> data;
+  if (!is_open() || !read_whole(entry, data)) return false;
+
+  entry_reader in(data);
+  char const *magic = in.get(sizeof(result_file_magic));
+  if (!in.ok() || 
+      (memcmp(magic, result_file_magic, sizeof(result_file_magic)) != 0) ||
+      (in.get_le(4) != result_file_version))
+    return false;
+
+  size_t key_size = in.get_le(4);
+  char const *stored_key = in.get(key_size);
+  if (!in.ok() || (key_size != key.size()) ||
+      (memcmp(stored_key, key.data(), key_size) != 0))
+    return false; // A different key with the same hash
+
+  evaluation_result found;
+  found.precision = in.get_double();
+  found.recall = in.get_double();
+  found.fscore = in.get_double();
+  found.nab.resize(std::min<u64>(in.get_le(4), nab_profile_count));
+  for (size_t i = 0; i < found.nab.size(); ++i)
+  {
+    found.nab[i].raw = in.get_double();
+    found.nab[i].normalized = in.get_double();
+    found.nab[i].true_positives = in.get_le(8);
+    found.nab[i].false_positives = in.get_le(8);
+    found.nab[i].false_negatives = in.get_le(8);
+  }
+  if (!in.ok() || !in.at_end()) return false;
+
+  touch(entry);
+  result = found;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void result_cache::store_result(std::string const &key,
+  evaluation_result const &result)
+{
+  if (!is_open()) return;
+
+  std::vector<char> data(result_file_magic, 
+                         result_file_magic + sizeof(result_file_magic));
+  put_le(data, result_file_version, 4);
+  put_le(data, key.size(), 4);
+  data.insert(data.end(), key.begin(), key.end());
+  put_double(data, result.precision);
+  put_double(data, result.recall);
+  put_double(data, result.fscore);
+  put_le(data, result.nab.size(), 4);
+  for (auto s = result.nab.begin(); s != result.nab.end(); ++s)
+  {
+    put_double(data, s->raw);
+    put_double(data, s->normalized);
+    put_le(data, s->true_positives, 8);
+    put_le(data, s->false_positives, 8);
+    put_le(data, s->false_negatives, 8);
+  }
+
+  store(dir_ + "/results/" + hex(hash_bytes(key.data(), key.size())), data);
+}
+
+//-----------------------------------------------------------------------------
+// Writes an entry under a temporary name (starting with '.') next to it and
+// renames it into place, replacing any entry of the same name.
+//-----------------------------------------------------------------------------
+void result_cache::store(std::string const &path, 
+  std::vector<char> const &data)
+{
+  static std::atomic<unsigned> sequence(0);
+  char suffix[64];
+  snprintf(suffix, sizeof(suffix), ".%ld.%u", (long)getpid(), 
+           sequence.fetch_add(1));
+  std::string temporary = path.substr(0, path.rfind('/') + 1) + suffix;
+
+  FILE *file = fopen(temporary.c_str(), "wb");
+  if (file == NULL) return;
+  bool ok = data.empty() || 
+            (fwrite(data.data(), 1, data.size(), file) == data.size());
+  ok = (fclose(file) == 0) && ok;
+
+  struct stat replaced;
+  long long change = data.size();
+  if (stat(path.c_str(), &replaced) == 0) change -= replaced.st_size;
+  if (!ok || (rename(temporary.c_str(), path.c_str()) != 0))
+  {
+    unlink(temporary.c_str());
+    return;
+  }
+
+  account(change);
+}
+
+//-----------------------------------------------------------------------------
+// Adds change bytes to the running size of the cache in <dir>/size, under an
+// exclusive lock of that file, and evicts once the size exceeds the limit.
+// The size is an estimate (entries replaced or removed concurrently may be
+// counted twice); every eviction scans the entries and writes the actual
+// size, as does the first store when the file is missing.
+//-----------------------------------------------------------------------------
+void result_cache::account(long long change)
+{
+  int fd = ::open((dir_ + "/size").c_str(), O_RDWR | O_CREAT | O_CLOEXEC,
+                  0666);
+  if (fd < 0) return;
+  if (flock(fd, LOCK_EX) != 0)
+  {
+    close(fd);
+    return;
+  }
+
+  char text[32];
+  ssize_t n = pread(fd, text, sizeof(text) - 1, 0);
+  u64 total = 0;
+  bool known = (n > 0);
+  if (known)
+  {
+    text[n] = '\0';
+    long long size = strtoll(text, NULL, 10) + change;
+    total = (size > 0) ? size : 0;
+  }
+  if (!known || (total > limit_)) total = evict();
+
+  n = snprintf(text, sizeof(text), "%llu\n", total);
+  if ((ftruncate(fd, 0) != 0) || (pwrite(fd, text, n, 0) != n))
+    unlink((dir_ + "/size").c_str()); // Rescanned by the next store
+  close(fd); // Releases the lock
+}
+
+//-----------------------------------------------------------------------------
+// Removes the least recently used entries once the entries exceed the limit,
+// down to 3/4 of it so that evictions are rare, and returns the size left.
+// Temporary files are left to their writers unless they are older than an
+// hour (and their writer likely gone).
+//-----------------------------------------------------------------------------
+u64 result_cache::evict()
+{
+  struct entry
+  {
+    long long modified;
+    u64 size;
+    std::string path;
+
+    bool operator<(entry const &other) const
+    {
+      return modified < other.modified;
+    }
+  };
+
+  std::vector<entry> entries;
+  u64 total = 0;
+  long long const stale = (time(NULL) - 3600) * 1000000000LL;
+
+  std::string const dirs[] = {dir_ + "/results/", dir_ + "/intervals/",
+                              dir_ + "/digests/"};
+  for (int i = 0; i < 3; ++i)
+  {
+    DIR *dir = opendir(dirs[i].c_str());
+    if (dir == NULL) continue;
+    while (dirent *file = readdir(dir))
+    {
+      std::string path = dirs[i] + file->d_name;
+      struct stat info;
+      if ((stat(path.c_str(), &info) != 0) || !S_ISREG(info.st_mode))
+        continue;
+
+      if (file->d_name[0] == '.')
+      {
+        if (modified(info) < stale) unlink(path.c_str());
+        continue;
+      }
+      entry e = {modified(info), (u64)info.st_size, path};
+      entries.push_back(e);
+      total += e.size;
+    }
+    closedir(dir);
+  }
+  if (total <= limit_) return total;
+
+  std::sort(entries.begin(), entries.end());
+  for (auto e = entries.begin(); (e != entries.end()) && 
+                                 (total > limit_ / 4 * 3); ++e)
+  {
+    unlink(e->path.c_str()); // Possibly removed by another process already
+    total -= e->size;
+  }
+  return total;
+}
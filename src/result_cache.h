@@ -0,0 +1,134 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#ifndef RESULT_CACHE_H_
+#define RESULT_CACHE_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "evaluator.h"
+#include "jobs.h"
+#include "nab.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// 64-bit xxHash (XXH64) of a buffer.
+//-----------------------------------------------------------------------------
+unsigned long long hash_bytes(void const *data, size_t size,
+  unsigned long long seed = 0);
+
+//-----------------------------------------------------------------------------
+// Content digest of a data file. Files that are not regular files (pipes,
+// "-" for stdin) have none.
+//-----------------------------------------------------------------------------
+struct file_digest
+{
+  unsigned long long hash; // hash_bytes of the contents
+  unsigned long long size;
+  long long modified; // Modification time, in nanoseconds
+  bool ranges; // An interval file or range list, cheap to read as it is
+};
+
+bool digest_file(std::string const &path, file_digest &digest);
+
+//-----------------------------------------------------------------------------
+// Metrics of one evaluation as the command line prints them.
+//-----------------------------------------------------------------------------
+struct evaluation_result
+{
+  evaluation_result() : precision(0), recall(0), fscore(0) {}
+
+  double precision;
+  double recall;
+  double fscore;
+  std::vector<nab_score> nab; // Numenta-like metrics (-n) only
+};
+
+//-----------------------------------------------------------------------------
+// On-disk cache of evaluation results and parsed data files, shared by any
+// number of concurrent processes:
+//
+//   <dir>/results/<key hash>     results, by data file digests and parameters
+//   <dir>/intervals/<digest>     anomaly ranges of a data file, as a compact
+//                                interval file (see interval_file.h)
+//   <dir>/digests/<file id hash> digest of a data file, by device, inode,
+//                                size and times, so that unchanged files are
+//                                not hashed again
+//   <dir>/size                   running size of the entries, in bytes
+//
+// Entries are written to a temporary file and renamed into place, so readers
+// never see partial entries; an entry that does not decode is a miss. Hits
+// refresh the modification time of their entry, and once the running size
+// exceeds the limit, the entries are scanned and the least recently used
+// ones removed. Results also depend on the evaluate binary itself, so a
+// rebuilt binary starts afresh.
+//
+// The cache is best effort: failing to store an entry is not an error.
+//-----------------------------------------------------------------------------
+class result_cache
+{
+public:
+
+  result_cache() : limit_(1ULL << 30) {}
+
+  // Uses (and creates, if needed) the cache in dir, holding at most limit
+  // bytes.
+  void open(std::string const &dir, unsigned long long limit);
+  bool is_open() const { return !dir_.empty(); }
+
+  // Reads a data file like read_file or read_file_unitsize, through the
+  // cache of parsed files.
+  time_intervals read_file(std::string const &path, bool unitsize,
+    timestamp &count);
+
+  // Key of the results of a job, from the digests of its data files and its
+  // metric and parameters. Returns false if the job cannot be cached (data
+  // not in regular files, or functions of a plugin).
+  bool make_key(evaluation_job const &job, std::string &key);
+
+  bool find_result(std::string const &key, evaluation_result &result);
+  void store_result(std::string const &key, evaluation_result const &result);
+
+private:
+
+  bool find_digest(std::string const &path, file_digest &digest);
+  void store(std::string const &path, std::vector<char> const &data);
+  void account(long long change);
+  unsigned long long evict();
+
+  std::string dir_;
+  unsigned long long limit_;
+  std::map<std::string, file_digest> digests_; // By file id, this process
+
+};
+
+}
+
+#endif // RESULT_CACHE_H_
@@ -0,0 +1,761 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "nab.h"
+#include "point_evaluator.h"
+#include "reader.h"
+#include "thread_pool.h"
+#include "tsad.h"
+
+using namespace anomaly;
+
+typedef unsigned long long u64;
+
+//-----------------------------------------------------------------------------
+static u64 get_le(char const *data, int bytes)
+{
+  u64 value = 0;
+  for (int i = bytes - 1; i >= 0; --i)
+    value = (value << 8) | (unsigned char)data[i];
+  return value;
+}
+
+//-----------------------------------------------------------------------------
+static void put_le(std::vector<char> &out, u64 value, int bytes)
+{
+  for (int i = 0; i < bytes; ++i, value >>= 8) out.push_back((char)value);
+}
+
+//-----------------------------------------------------------------------------
+static double get_double(char const *data)
+{
+  u64 bits = get_le(data, 8);
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+//-----------------------------------------------------------------------------
+static void put_double(std::vector<char> &out, double value)
+{
+  u64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  put_le(out, bits, 8);
+}
+
+//-----------------------------------------------------------------------------
+// Reads exactly size bytes. Returns false if the peer closed the connection
+// before the first byte.
+//-----------------------------------------------------------------------------
+static bool read_full(int fd, char *data, size_t size)
+{
+  size_t done = 0;
+  while (done < size)
+  {
+    ssize_t n = read(fd, data + done, size - done);
+    if ((n < 0) && (errno == EINTR)) continue;
+    if (n < 0) throw "Error: Could not read from socket!";
+    if (n == 0)
+    {
+      if (done == 0) return false;
+      throw "Error: Connection closed!";
+    }
+    done += n;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Writes all of data, waiting for a non-blocking socket to take more, but
+// not longer than server_write_timeout at a time.
+//-----------------------------------------------------------------------------
+static void write_full(int fd, char const *data, size_t size)
+{
+  size_t done = 0;
+  while (done < size)
+  {
+    ssize_t n = send(fd, data + done, size - done, MSG_NOSIGNAL);
+    if ((n < 0) && (errno == EINTR)) continue;
+    if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+    {
+      pollfd writable = {fd, POLLOUT, 0};
+      int ready = poll(&writable, 1, server_write_timeout);
+      if ((ready < 0) && (errno == EINTR)) continue;
+      if (ready <= 0) throw "Error: Could not write to socket!";
+      continue;
+    }
+    if (n < 0) throw "Error: Could not write to socket!";
+    done += n;
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Frames are built with a placeholder for their size in front.
+//-----------------------------------------------------------------------------
+static void write_frame(int fd, std::vector<char> &frame)
+{
+  if (frame.size() - 4 > 0xFFFFFFFFULL) throw "Error: Request too large!";
+  std::vector<char> size;
+  put_le(size, frame.size() - 4, 4);
+  std::copy(size.begin(), size.end(), frame.begin());
+  write_full(fd, frame.data(), frame.size());
+}
+
+//-----------------------------------------------------------------------------
+// Reads a frame on the client side, blocking.
+//-----------------------------------------------------------------------------
+static bool read_frame(int fd, std::vector<char> &payload)
+{
+  char size[4];
+  if (!read_full(fd, size, sizeof(size))) return false;
+  payload.resize(get_le(size, 4));
+  if (!read_full(fd, payload.data(), payload.size()))
+    throw "Error: Connection closed!";
+  return true;
+}
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// A real file as parsed, and the file status it was parsed with.
+//-----------------------------------------------------------------------------
+struct ground_truth
+{
+  time_intervals anomalies;
+  timestamp count;
+  struct stat info;
+};
+
+//-----------------------------------------------------------------------------
+// Real files by path, kept until the file on disk changes, and least recently
+// used first evicted once they hold more than server_truth_capacity ranges
+// (a file counting one more than its ranges). A file larger than that is
+// still kept while it is the only one.
+//-----------------------------------------------------------------------------
+class ground_truth_cache
+{
+public:
+
+  ground_truth_cache() : size_(0) {}
+
+  std::shared_ptr<ground_truth const> get(std::string const &path)
+  {
+    struct stat info;
+    if ((stat(path.c_str(), &info) != 0) || !S_ISREG(info.st_mode))
+      throw "Error: Could not open file!";
+
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      auto i = files_.find(path);
+      if ((i != files_.end()) && same_file(i->second.truth->info, info))
+      {
+        recent_.splice(recent_.begin(), recent_, i->second.position);
+        return i->second.truth;
+      }
+    }
+
+    // Parsed without the lock; concurrent first requests for the same file
+    // may each parse it, and the last one is kept.
+    std::shared_ptr<ground_truth> truth(new ground_truth);
+    truth->anomalies = read_file(path, truth->count);
+    truth->info = info;
+
+    std::lock_guard<std::mutex> guard(lock_);
+    auto i = files_.find(path);
+    if (i != files_.end()) erase(i);
+    recent_.push_front(path);
+    entry &e = files_[path];
+    e.truth = truth;
+    e.position = recent_.begin();
+    size_ += cost(*truth);
+    while ((size_ > server_truth_capacity) && (recent_.size() > 1))
+      erase(files_.find(recent_.back()));
+    return truth;
+  }
+
+private:
+
+  struct entry
+  {
+    std::shared_ptr<ground_truth const> truth;
+    std::list<std::string>::iterator position; // In recent_
+  };
+
+  typedef std::map<std::string, entry> file_map;
+
+  static size_t cost(ground_truth const &truth)
+  {
+    return truth.anomalies.size() + 1;
+  }
+
+  static bool same_file(struct stat const &a, struct stat const &b)
+  {
+    return (a.st_dev == b.st_dev) && (a.st_ino == b.st_ino) &&
+           (a.st_size == b.st_size) && 
+           (a.st_mtim.tv_sec == b.st_mtim.tv_sec) &&
+           (a.st_mtim.tv_nsec == b.st_mtim.tv_nsec);
+  }
+
+  // Requests in progress keep their files until they are done.
+  void erase(file_map::iterator i)
+  {
+    size_ -= cost(*i->second.truth);
+    recent_.erase(i->second.position);
+    files_.erase(i);
+  }
+
+  std::mutex lock_;
+  file_map files_;
+  std::list<std::string> recent_; // Paths, most recently used first
+  size_t size_; // Ranges held, plus one per file
+};
+
+//-----------------------------------------------------------------------------
+// A client connection and the request frame read from it so far. The poll
+// thread reads frames as their bytes arrive, and a worker then serves the
+// complete request, so that slow clients never hold a worker.
+//-----------------------------------------------------------------------------
+struct connection
+{
+  explicit connection(int fd) : fd(fd), filled(0) {}
+
+  int fd;
+  std::vector<char> frame; // Size, then payload, reused from request to request
+  size_t filled;
+};
+
+//-----------------------------------------------------------------------------
+struct request
+{
+  int metrics;
+  int gamma;
+  int delta_p;
+  int delta_r;
+  double beta;
+  double alpha_r;
+  timestamp count;
+  std::string real_path;
+};
+
+}
+
+//-----------------------------------------------------------------------------
+// Decodes a request payload; predicted labels are turned into ranges.
+//-----------------------------------------------------------------------------
+static void decode_request(char const *data, size_t size, request &r,
+  time_intervals &predicted)
+{
+  if (size < server_request_header_size) throw "Error: Invalid request!";
+
+  r.metrics = (unsigned char)data[0];
+  r.gamma = (unsigned char)data[1];
+  r.delta_p = (unsigned char)data[2];
+  r.delta_r = (unsigned char)data[3];
+  unsigned char encoding = data[4];
+  r.beta = get_double(data + 8);
+  r.alpha_r = get_double(data + 16);
+  u64 count = get_le(data + 24, 8);
+  u64 path_size = get_le(data + 32, 4);
+
+  if ((count > (u64)LLONG_MAX) || 
+      (path_size > size - server_request_header_size))
+    throw "Error: Invalid request!";
+  r.count = (timestamp)count;
+  r.real_path.assign(data + server_request_header_size, path_size);
+
+  data += server_request_header_size + path_size;
+  size -= server_request_header_size + path_size;
+
+  if (encoding == server_predicted_labels)
+  {
+    if (size != count) throw "Error: Number of data items are different!";
+    read_labels((unsigned char const *)data, size, false, predicted);
+    return;
+  }
+  if ((encoding != server_predicted_ranges) || (size % 16 != 0))
+    throw "Error: Invalid request!";
+
+  predicted.resize(size / 16);
+  for (size_t i = 0; i < predicted.size(); ++i, data += 16)
+  {
+    time_range &range = predicted[i];
+    range.first = (timestamp)get_le(data, 8);
+    range.second = (timestamp)get_le(data + 8, 8);
+    if ((range.first < 0) || (range.first > range.second) || 
+        (range.second >= r.count) || 
+        ((i > 0) && (range.first <= predicted[i - 1].second)))
+      throw "Error: Invalid predicted ranges!";
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Evaluates a request like the command line does: point metrics with
+// point_evaluator, time series metrics with evaluator.
+//-----------------------------------------------------------------------------
+static void evaluate_request(request const &r, ground_truth const &truth,
+  time_intervals const &predicted, evaluation_result &result)
+{
+  if (r.count != truth.count) 
+    throw "Error: Number of data items are different!";
+  if (r.count == 0) throw "Error: No data items!";
+
+  if ((r.metrics == TSAD_METRICS_CLASSICAL) || 
+      (r.metrics == TSAD_METRICS_NUMENTA))
+  {
+    point_evaluator e(truth.anomalies, predicted, truth.count, 
+                      r.metrics == TSAD_METRICS_CLASSICAL, 1, 0, e_one, 
+                      e_flat, e_flat);
+    evaluator &params = e.get_parameters();
+    params.set_beta(r.beta);
+    params.set_alpha_r(r.alpha_r);
+    params.set_gamma((overlap_cardinality)r.gamma);
+    params.set_delta_p((positional_bias)r.delta_p);
+    params.set_delta_r((positional_bias)r.delta_r);
+    e.update_precision();
+    e.update_recall();
+    e.update_fscore();
+
+    result.precision = e.get_precision();
+    result.recall = e.get_recall();
+    result.fscore = e.get_fscore();
+    if (r.metrics == TSAD_METRICS_NUMENTA)
+      result.nab = compute_nab_scores(interval_span(truth.anomalies), 
+                                      interval_span(predicted));
+    return;
+  }
+  if (r.metrics != TSAD_METRICS_TIME_SERIES) 
+    throw "Error: Invalid metric option!";
+
+  evaluator e((interval_span(truth.anomalies)), interval_span(predicted));
+  e.set_beta(r.beta);
+  e.set_alpha_r(r.alpha_r);
+  e.set_gamma((overlap_cardinality)r.gamma);
+  e.set_delta_p((positional_bias)r.delta_p);
+  e.set_delta_r((positional_bias)r.delta_r);
+  e.update_precision();
+  e.update_recall();
+  e.update_fscore();
+
+  result.precision = e.get_precision();
+  result.recall = e.get_recall();
+  result.fscore = e.get_fscore();
+}
+
+//-----------------------------------------------------------------------------
+// Reads what has arrived of the request frame of a connection, without
+// blocking. Returns 1 once the frame is complete, 0 while it is not, and -1
+// if the connection is closed or broken, or the frame is too large. The
+// buffer grows with the data that arrives rather than with the size that
+// the frame announces.
+//-----------------------------------------------------------------------------
+static int read_request(connection &c)
+{
+  for (;;)
+  {
+    size_t wanted = 4;
+    if (c.filled >= 4)
+    {
+      u64 size = get_le(c.frame.data(), 4);
+      if (size > server_max_request_size) return -1;
+      wanted += size;
+      if (c.filled == wanted) return 1;
+    }
+
+    size_t chunk = std::min<size_t>(wanted - c.filled, 
+                                     std::max<size_t>(c.filled, 1 << 16));
+    if (c.frame.size() < c.filled + chunk) c.frame.resize(c.filled + chunk);
+    ssize_t n = read(c.fd, c.frame.data() + c.filled, chunk);
+    if ((n < 0) && (errno == EINTR)) continue;
+    if (n < 0) return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1;
+    if (n == 0) return -1;
+    c.filled += n;
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Serves the complete request of a connection. Returns false if the
+// connection is broken. Errors of the request itself are sent to the client.
+//-----------------------------------------------------------------------------
+static bool serve_request(connection &c, ground_truth_cache &truths)
+{
+  // Buffer of each worker, reused from request to request.
+  static thread_local time_intervals predicted;
+
+  std::vector<char> response(4);
+  try
+  {
+    request r;
+    decode_request(c.frame.data() + 4, c.filled - 4, r, predicted);
+    std::shared_ptr<ground_truth const> truth = truths.get(r.real_path);
+
+    evaluation_result result;
+    evaluate_request(r, *truth, predicted, result);
+    put_le(response, 0, 4);
+    put_double(response, result.precision);
+    put_double(response, result.recall);
+    put_double(response, result.fscore);
+    if (r.metrics == TSAD_METRICS_NUMENTA)
+    {
+      put_le(response, result.nab.size(), 4);
+      for (auto n = result.nab.begin(); n != result.nab.end(); ++n)
+      {
+        put_double(response, n->raw);
+        put_double(response, n->normalized);
+        put_le(response, n->true_positives, 8);
+        put_le(response, n->false_positives, 8);
+        put_le(response, n->false_negatives, 8);
+      }
+    }
+  }
+  catch (const char *msg)
+  {
+    put_le(response, 1, 4);
+    response.insert(response.end(), msg, msg + strlen(msg));
+  }
+  catch (std::bad_alloc const &)
+  {
+    static const char msg[] = "Error: Out of memory!";
+    put_le(response, 1, 4);
+    response.insert(response.end(), msg, msg + sizeof(msg) - 1);
+  }
+  catch (...)
+  {
+    static const char msg[] = "Error: Evaluation failed!";
+    put_le(response, 1, 4);
+    response.insert(response.end(), msg, msg + sizeof(msg) - 1);
+  }
+
+  // Buffers of large requests are not kept for the next one.
+  c.filled = 0;
+  if (c.frame.size() > (1 << 24)) std::vector<char>().swap(c.frame);
+
+  try
+  {
+    write_frame(c.fd, response);
+  }
+  catch (...)
+  {
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+static void close_connection(connection *c)
+{
+  close(c->fd);
+  delete c;
+}
+
+//-----------------------------------------------------------------------------
+// Binds a listening socket at path, replacing a socket file that no server
+// listens on any more.
+//-----------------------------------------------------------------------------
+static int listen_on(std::string const &path)
+{
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) 
+    throw "Error: Socket path too long!";
+  memcpy(address.sun_path, path.c_str(), path.size());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) throw "Error: Could not create socket!";
+
+  if (bind(fd, (sockaddr *)&address, sizeof(address)) != 0)
+  {
+    struct stat info;
+    bool stale = (errno == EADDRINUSE) && 
+                 (lstat(path.c_str(), &info) == 0) && S_ISSOCK(info.st_mode);
+    if (stale)
+    {
+      int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      stale = (probe >= 0) &&
+              (connect(probe, (sockaddr *)&address, sizeof(address)) != 0) &&
+              (errno == ECONNREFUSED);
+      if (probe >= 0) close(probe);
+    }
+    if (!stale || (unlink(path.c_str()) != 0) ||
+        (bind(fd, (sockaddr *)&address, sizeof(address)) != 0))
+    {
+      close(fd);
+      throw "Error: Could not bind socket!";
+    }
+  }
+
+  if (listen(fd, SOMAXCONN) != 0)
+  {
+    close(fd);
+    unlink(path.c_str());
+    throw "Error: Could not listen on socket!";
+  }
+  return fd;
+}
+
+static int stop_fd = -1; // Write end of the pipe that stops the server
+
+static void stop_server(int)
+{
+  int saved = errno;
+  if (write(stop_fd, "", 1) < 0) {} // Already stopping if the pipe is full.
+  errno = saved;
+}
+
+//-----------------------------------------------------------------------------
+// The calling thread waits for connections and reads their requests; a
+// connection with a complete request is handed to the pool, whose worker
+// serves it and hands the connection back. Connections that are idle, or
+// slow to send their requests, thus never hold a worker.
+//-----------------------------------------------------------------------------
+void anomaly::run_server(std::string const &path, unsigned threads)
+{
+  int stop[2], wake[2];
+  if (pipe(stop) != 0) throw "Error: Could not start server!";
+  if (pipe(wake) != 0)
+  {
+    close(stop[0]);
+    close(stop[1]);
+    throw "Error: Could not start server!";
+  }
+
+  int listener = -1;
+  try
+  {
+    listener = listen_on(path);
+  }
+  catch (...)
+  {
+    close(stop[0]);
+    close(stop[1]);
+    close(wake[0]);
+    close(wake[1]);
+    throw;
+  }
+
+  stop_fd = stop[1];
+  struct sigaction action, old_int, old_term;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = stop_server;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, &old_int);
+  sigaction(SIGTERM, &action, &old_term);
+
+  ground_truth_cache truths;
+  std::mutex lock;
+  std::vector<connection *> returned; // Handed back by workers
+  std::vector<connection *> idle;     // Waiting for (the rest of) a request
+  std::vector<pollfd> fds;
+  char const *error = NULL;
+
+  {
+    thread_pool pool(threads);
+    for (;;)
+    {
+      fds.clear();
+      int const own[] = {stop[0], wake[0], listener};
+      for (int i = 0; i < 3; ++i) fds.push_back(pollfd{own[i], POLLIN, 0});
+      for (auto c = idle.begin(); c != idle.end(); ++c)
+        fds.push_back(pollfd{(*c)->fd, POLLIN, 0});
+
+      if (poll(fds.data(), fds.size(), -1) < 0)
+      {
+        if (errno == EINTR) continue;
+        error = "Error: Could not wait for requests!";
+        break;
+      }
+      if (fds[0].revents != 0) break;
+
+      std::vector<connection *> polled;
+      polled.swap(idle);
+      for (size_t i = 0; i < polled.size(); ++i)
+      {
+        connection *c = polled[i];
+        int state = (fds[i + 3].revents != 0) ? read_request(*c) : 0;
+        if (state < 0) close_connection(c);
+        if (state == 0) idle.push_back(c);
+        if (state <= 0) continue;
+
+        pool.submit([&, c]
+        {
+          if (!serve_request(*c, truths))
+          {
+            close_connection(c);
+            return;
+          }
+          std::lock_guard<std::mutex> guard(lock);
+          returned.push_back(c);
+          if (write(wake[1], "", 1) < 0) {} // A wake-up is pending anyway.
+        });
+      }
+
+      if (fds[1].revents != 0)
+      {
+        char drain[256];
+        if (read(wake[0], drain, sizeof(drain)) < 0) {}
+        std::lock_guard<std::mutex> guard(lock);
+        idle.insert(idle.end(), returned.begin(), returned.end());
+        returned.clear();
+      }
+
+      if (fds[2].revents != 0)
+      {
+        int fd = accept4(listener, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (fd >= 0) idle.push_back(new connection(fd));
+      }
+    }
+
+    close(listener);
+    unlink(path.c_str());
+    pool.wait(); // Requests in progress are answered.
+  }
+
+  for (auto c = idle.begin(); c != idle.end(); ++c) close_connection(*c);
+  for (auto c = returned.begin(); c != returned.end(); ++c) 
+    close_connection(*c);
+
+  sigaction(SIGINT, &old_int, NULL);
+  sigaction(SIGTERM, &old_term, NULL);
+  stop_fd = -1;
+  close(stop[0]);
+  close(stop[1]);
+  close(wake[0]);
+  close(wake[1]);
+
+  if (error != NULL) throw error;
+}
+
+//-----------------------------------------------------------------------------
+server_connection::server_connection(std::string const &path)
+{
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) 
+    throw "Error: Socket path too long!";
+  memcpy(address.sun_path, path.c_str(), path.size());
+
+  fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd_ < 0) throw "Error: Could not create socket!";
+  if (connect(fd_, (sockaddr *)&address, sizeof(address)) != 0)
+  {
+    close(fd_);
+    throw "Error: Could not connect to server!";
+  }
+}
+
+//-----------------------------------------------------------------------------
+server_connection::~server_connection()
+{
+  close(fd_);
+}
+
+//-----------------------------------------------------------------------------
+void server_connection::evaluate(evaluation_job const &job,
+  time_intervals const &predicted, timestamp count, 
+  evaluation_result &result)
+{
+  if (!job.gamma_udf.empty() || !job.delta_p_udf.empty() || 
+      !job.delta_r_udf.empty())
+    throw "Error: Plugin functions are not supported by the server!";
+
+  int metrics = (job.metric_option == "-c") ? TSAD_METRICS_CLASSICAL :
+                (job.metric_option == "-n") ? TSAD_METRICS_NUMENTA : 
+                                              TSAD_METRICS_TIME_SERIES;
+
+  std::vector<char> frame(4);
+  frame.reserve(4 + server_request_header_size + job.real_file.size() + 
+                16 * predicted.size());
+  put_le(frame, metrics, 1);
+  put_le(frame, job.gamma, 1);
+  put_le(frame, job.delta_p, 1);
+  put_le(frame, job.delta_r, 1);
+  put_le(frame, server_predicted_ranges, 1);
+  put_le(frame, 0, 3);
+  put_double(frame, job.beta);
+  put_double(frame, job.alpha_r);
+  put_le(frame, count, 8);
+  put_le(frame, job.real_file.size(), 4);
+  frame.insert(frame.end(), job.real_file.begin(), job.real_file.end());
+  for (auto r = predicted.begin(); r != predicted.end(); ++r)
+  {
+    put_le(frame, r->first, 8);
+    put_le(frame, r->second, 8);
+  }
+  write_frame(fd_, frame);
+
+  std::vector<char> payload;
+  if (!read_frame(fd_, payload) || (payload.size() < 4))
+    throw "Error: Connection closed!";
+  if (get_le(payload.data(), 4) != 0)
+  {
+    throw std::string(payload.begin() + 4, payload.end());
+  }
+  if (payload.size() < 4 + 3 * 8) throw "Error: Invalid response!";
+  result.precision = get_double(&payload[4]);
+  result.recall = get_double(&payload[12]);
+  result.fscore = get_double(&payload[20]);
+  result.nab.clear();
+  if (metrics != TSAD_METRICS_NUMENTA)
+  {
+    if (payload.size() != 4 + 3 * 8) throw "Error: Invalid response!";
+    return;
+  }
+
+  if ((payload.size() < 4 + 3 * 8 + 4) ||
+      (payload.size() != 4 + 3 * 8 + 4 + 40 * get_le(&payload[28], 4)))
+    throw "Error: Invalid response!";
+  result.nab.resize(get_le(&payload[28], 4));
+  for (size_t i = 0; i < result.nab.size(); ++i)
+  {
+    char const *data = &payload[32 + 40 * i];
+    result.nab[i].raw = get_double(data);
+    result.nab[i].normalized = get_double(data + 8);
+    result.nab[i].true_positives = get_le(data + 16, 8);
+    result.nab[i].false_positives = get_le(data + 24, 8);
+    result.nab[i].false_negatives = get_le(data + 32, 8);
+  }
+}
@@ -0,0 +1,123 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include <string>
+
+#include "evaluator.h"
+#include "jobs.h"
+#include "result_cache.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Evaluation server on a Unix domain socket. Clients keep a connection open
+// and send requests, each answered in order by a response. A request names a
+// real data file on the server's machine and carries the predicted anomalies
+// itself; real files are parsed once and kept resident, and reloaded when
+// they change on disk.
+//
+// Every frame is a 4-byte payload size followed by the payload (all integers
+// and doubles little-endian). Request payload:
+//
+//   offset  size  field
+//   0       1     metrics (TSAD_METRICS_* of tsad.h)
+//   1       1     gamma (TSAD_GAMMA_*)
+//   2       1     delta_p (TSAD_DELTA_*)
+//   3       1     delta_r (TSAD_DELTA_*)
+//   4       1     predicted encoding: 0 for labels, 1 for ranges
+//   5       3     reserved, 0
+//   8       8     beta (float64)
+//   16      8     alpha_r (float64)
+//   24      8     series length, i.e., number of labels
+//   32      4     length P of the real file path
+//   36      P     real file path, absolute or relative to the server
+//   36+P    ...   predicted labels, one byte each (nonzero for anomalies),
+//                 or predicted ranges as sorted, disjoint pairs of int64
+//                 (start, end) label positions, both inclusive
+//
+// Response payload: a 4-byte status, then either precision, recall and
+// F-Score (float64) for status 0, or the error message for status 1. For
+// Numenta-like metrics, status 0 goes on with the NAB scores:
+//
+//   offset  size  field
+//   28      4     number N of NAB profiles (see nab.h)
+//   32      40*N  per profile: raw and normalized score (float64), true
+//                 positives, false positives and false negatives (int64)
+//
+// Results are those of the command line (-c, -t or -n with the same
+// parameters); the udfs are the compiled-in ones.
+//
+// Requests larger than server_max_request_size close the connection, as do
+// clients that take longer than server_write_timeout (milliseconds) to make
+// room for a response. Real files are kept resident up to
+// server_truth_capacity ranges in all, the least recently used ones making
+// room for others.
+//-----------------------------------------------------------------------------
+static const size_t server_request_header_size = 36;
+static const unsigned long long server_max_request_size = 1ULL << 30;
+static const int server_write_timeout = 10000;
+static const size_t server_truth_capacity = 1 << 26; // 1 GiB of ranges
+static const unsigned char server_predicted_labels = 0;
+static const unsigned char server_predicted_ranges = 1;
+
+//-----------------------------------------------------------------------------
+// Listens on the socket at path and serves requests on a pool of the given
+// number of threads (0 for one per hardware thread) until SIGINT or SIGTERM.
+// A stale socket file left at path is replaced.
+//-----------------------------------------------------------------------------
+void run_server(std::string const &path, unsigned threads);
+
+//-----------------------------------------------------------------------------
+// Client side of a connection to the server.
+//-----------------------------------------------------------------------------
+class server_connection
+{
+public:
+
+  explicit server_connection(std::string const &path);
+  ~server_connection();
+
+  // Evaluates the predicted ranges of a series of count labels against the
+  // real file of the job, with its metric option and parameters. Errors
+  // reported by the server are thrown as std::string, since the message
+  // must outlive the connection; local errors as const char*.
+  void evaluate(evaluation_job const &job, time_intervals const &predicted,
+    timestamp count, evaluation_result &result);
+
+private:
+
+  server_connection(server_connection const &);
+  server_connection & operator=(server_connection const &);
+
+  int fd_;
+};
+
+}
+
+#endif // SERVER_H_
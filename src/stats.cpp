@@ -0,0 +1,190 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "stats.h"
+
+#include <mutex>
+#include <sys/resource.h>
+#include <time.h>
+
+using namespace anomaly;
+
+//-----------------------------------------------------------------------------
+char const * anomaly::stat_counter_name(stat_counter counter)
+{
+  switch (counter)
+  {
+    case c_bytes_read: return "bytes_read";
+    case c_range_pairs: return "range_pairs";
+    case c_overlapping_pairs: return "overlapping_pairs";
+    case c_omega_evaluations: return "omega_evaluations";
+    case c_delta_calls: return "delta_calls";
+    case c_udf_calls: return "udf_calls";
+    default: return "unknown";
+  }
+}
+
+#ifdef TSAD_STATS
+
+static std::mutex blocks_lock;
+static std::vector<stat_block *> blocks; // Never freed, as threads may come
+                                         // and go while counters are read.
+
+//-----------------------------------------------------------------------------
+stat_block * anomaly::new_stat_block()
+{
+  stat_block *block = new stat_block;
+  for (int i = 0; i < c_stat_counters; ++i) block->values[i] = 0;
+
+  std::lock_guard<std::mutex> guard(blocks_lock);
+  blocks.push_back(block);
+  return block;
+}
+
+//-----------------------------------------------------------------------------
+bool anomaly::stat_counters_enabled()
+{
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long anomaly::get_stat(stat_counter counter)
+{
+  std::lock_guard<std::mutex> guard(blocks_lock);
+  unsigned long long sum = 0;
+  for (auto b = blocks.begin(); b != blocks.end(); ++b)
+    sum += (*b)->values[counter].load(std::memory_order_relaxed);
+  return sum;
+}
+
+#else
+
+//-----------------------------------------------------------------------------
+bool anomaly::stat_counters_enabled()
+{
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long anomaly::get_stat(stat_counter)
+{
+  return 0;
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+static double clock_seconds(clockid_t clock)
+{
+  struct timespec now;
+  clock_gettime(clock, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+//-----------------------------------------------------------------------------
+long anomaly::peak_rss_kib()
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  return usage.ru_maxrss; // Already in KiB on Linux
+}
+
+//-----------------------------------------------------------------------------
+stats_phase::stats_phase(run_stats &stats, char const *name)
+: stats_(stats), name_(name)
+{
+  // Clocks are read even if disabled, as the statistics may be enabled
+  // within the phase (as with the whole command line).
+  wall_start_ = clock_seconds(CLOCK_MONOTONIC);
+  cpu_start_ = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+//-----------------------------------------------------------------------------
+stats_phase::~stats_phase()
+{
+  if (!stats_.is_enabled()) return;
+
+  phase_time phase;
+  phase.name = name_;
+  phase.wall_seconds = clock_seconds(CLOCK_MONOTONIC) - wall_start_;
+  phase.cpu_seconds = clock_seconds(CLOCK_PROCESS_CPUTIME_ID) - cpu_start_;
+  stats_.add_phase(phase);
+}
+
+//-----------------------------------------------------------------------------
+void run_stats::write_text(std::ostream &out) const
+{
+  out << "Phase times (wall, CPU):" << std::endl;
+  for (auto p = phases_.begin(); p != phases_.end(); ++p)
+  {
+    out << "  " << p->name << " = " << p->wall_seconds << " s, " 
+        << p->cpu_seconds << " s" << std::endl;
+  }
+  out << "Peak RSS = " << peak_rss_kib() << " KiB" << std::endl;
+
+  if (!stat_counters_enabled())
+  {
+    out << "Counters: not compiled in (build with make STATS=1)" << std::endl;
+    return;
+  }
+
+  out << "Counters:" << std::endl;
+  for (int c = 0; c < c_stat_counters; ++c)
+  {
+    out << "  " << stat_counter_name((stat_counter)c) << " = " 
+        << get_stat((stat_counter)c) << std::endl;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void run_stats::write_json(std::ostream &out) const
+{
+  out << "{" << std::endl << "  \"phases\": [";
+  for (auto p = phases_.begin(); p != phases_.end(); ++p)
+  {
+    out << ((p == phases_.begin()) ? "" : ",") << std::endl
+        << "    {\"name\": \"" << p->name << "\", \"wall_seconds\": " 
+        << p->wall_seconds << ", \"cpu_seconds\": " << p->cpu_seconds << "}";
+  }
+  out << std::endl << "  ]," << std::endl;
+  out << "  \"peak_rss_kib\": " << peak_rss_kib() << "," << std::endl;
+
+  out << "  \"counters\": ";
+  if (!stat_counters_enabled())
+  {
+    out << "null" << std::endl << "}" << std::endl;
+    return;
+  }
+
+  out << "{";
+  for (int c = 0; c < c_stat_counters; ++c)
+  {
+    out << ((c == 0) ? "" : ",") << std::endl << "    \"" 
+        << stat_counter_name((stat_counter)c) << "\": " 
+        << get_stat((stat_counter)c);
+  }
+  out << std::endl << "  }" << std::endl << "}" << std::endl;
+}
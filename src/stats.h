@@ -0,0 +1,147 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef TSAD_STATS
+#include <atomic>
+#endif
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Hot-path counters. They are only compiled in with TSAD_STATS defined
+// (make STATS=1); otherwise TSAD_COUNT expands to nothing and all counters
+// read as zero.
+//-----------------------------------------------------------------------------
+typedef enum
+{
+  c_bytes_read,          // Bytes of data files loaded
+  c_range_pairs,         // Range pairs examined for overlap
+  c_overlapping_pairs,   // Of those, pairs that overlap
+  c_omega_evaluations,   // Calls of the omega function
+  c_delta_calls,         // Positional bias values computed one by one
+  c_udf_calls,           // Calls of user-defined gamma and delta functions
+  c_stat_counters
+} stat_counter;
+
+char const * stat_counter_name(stat_counter counter);
+
+#ifdef TSAD_STATS
+
+// Each thread counts in a block of its own, so counting takes no lock and
+// no atomic read-modify-write; blocks are summed when counters are read.
+struct stat_block
+{
+  std::atomic<unsigned long long> values[c_stat_counters];
+};
+
+stat_block * new_stat_block();
+
+inline void count_stat(stat_counter counter, unsigned long long n)
+{
+  static thread_local stat_block *block = new_stat_block();
+  std::atomic<unsigned long long> &value = block->values[counter];
+  value.store(value.load(std::memory_order_relaxed) + n, 
+              std::memory_order_relaxed);
+}
+
+#define TSAD_COUNT(counter, n) ::anomaly::count_stat(counter, n)
+#else
+#define TSAD_COUNT(counter, n) ((void)0)
+#endif
+
+// True if the counters are compiled in.
+bool stat_counters_enabled();
+
+// Sum of a counter over all threads so far.
+unsigned long long get_stat(stat_counter counter);
+
+//-----------------------------------------------------------------------------
+// Wall clock and CPU time (of all threads of the process) per phase of a
+// run. Phases are only timed while the statistics are enabled.
+//-----------------------------------------------------------------------------
+struct phase_time
+{
+  std::string name;
+  double wall_seconds;
+  double cpu_seconds;
+};
+
+class run_stats
+{
+public:
+
+  run_stats() : enabled_(false) {}
+
+  void enable() { enabled_ = true; }
+  bool is_enabled() const { return enabled_; }
+
+  void add_phase(phase_time const &phase) { phases_.push_back(phase); }
+
+  // Phases, peak resident set size, and counters, as text or JSON.
+  void write_text(std::ostream &out) const;
+  void write_json(std::ostream &out) const;
+
+private:
+
+  bool enabled_;
+  std::vector<phase_time> phases_;
+};
+
+//-----------------------------------------------------------------------------
+// Times the enclosing scope as a phase of stats, if enabled by its end.
+//-----------------------------------------------------------------------------
+class stats_phase
+{
+public:
+
+  stats_phase(run_stats &stats, char const *name);
+  ~stats_phase();
+
+private:
+
+  stats_phase(stats_phase const &);
+  stats_phase & operator=(stats_phase const &);
+
+  run_stats &stats_;
+  char const *name_;
+  double wall_start_;
+  double cpu_start_;
+};
+
+// Peak resident set size of the process in KiB.
+long peak_rss_kib();
+
+}
+
+#endif // STATS_H_
@@ -0,0 +1,168 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#include "stream_evaluator.h"
+
+using namespace anomaly;
+
+//-----------------------------------------------------------------------------
+void stream_evaluator::reset()
+{
+  count_ = 0;
+  finished_ = false;
+  real_open_ = predicted_open_ = overlap_open_ = false;
+  real_overlaps_.clear();
+  predicted_overlaps_.clear();
+  precision_sum_ = recall_sum_ = 0.0;
+  predicted_closed_ = real_closed_ = 0;
+}
+
+//-----------------------------------------------------------------------------
+// The open overlap belongs to both open ranges.
+//-----------------------------------------------------------------------------
+void stream_evaluator::close_overlap()
+{
+  real_overlaps_.push_back(overlap_);
+  predicted_overlaps_.push_back(overlap_);
+  overlap_open_ = false;
+}
+
+//-----------------------------------------------------------------------------
+void stream_evaluator::push(int real, int predicted)
+{
+  if (finished_) throw "Error: Stream already finished!";
+  if (((real != 0) && (real != 1)) || ((predicted != 0) && (predicted != 1)))
+    throw "Error: Invalid anomaly label!";
+
+  if (overlap_open_ && !(real && predicted)) close_overlap();
+
+  if (real_open_ && !real) // Real range ended at the previous label.
+  {
+    recall_sum_ += params_.compute_range_reward(e_recall, real_,
+      real_overlaps_.data(), real_overlaps_.size());
+    ++real_closed_;
+    real_overlaps_.clear();
+    real_open_ = false;
+  }
+
+  if (predicted_open_ && !predicted)
+  {
+    precision_sum_ += params_.compute_range_reward(e_precision, predicted_,
+      predicted_overlaps_.data(), predicted_overlaps_.size());
+    ++predicted_closed_;
+    predicted_overlaps_.clear();
+    predicted_open_ = false;
+  }
+
+  if (real)
+  {
+    if (!real_open_) real_.first = count_;
+    real_.second = count_;
+    real_open_ = true;
+  }
+
+  if (predicted)
+  {
+    if (!predicted_open_) predicted_.first = count_;
+    predicted_.second = count_;
+    predicted_open_ = true;
+  }
+
+  if (real && predicted)
+  {
+    if (!overlap_open_) overlap_.first = count_;
+    overlap_.second = count_;
+    overlap_open_ = true;
+  }
+
+  ++count_;
+}
+
+//-----------------------------------------------------------------------------
+void stream_evaluator::push(int const *real, int const *predicted, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) push(real[i], predicted[i]);
+}
+
+//-----------------------------------------------------------------------------
+void stream_evaluator::finish()
+{
+  if (finished_) return;
+
+  push(0, 0); // Closes everything; the extra label is not counted.
+  --count_;
+  finished_ = true;
+}
+
+//-----------------------------------------------------------------------------
+// Reward of an open range if it ended with the last pushed label.
+//-----------------------------------------------------------------------------
+double stream_evaluator::open_reward(e_metric m, time_range range,
+  time_intervals const &overlaps) const
+{
+  if (!overlap_open_)
+    return params_.compute_range_reward(m, range, overlaps.data(), 
+                                        overlaps.size());
+
+  time_intervals all(overlaps);
+  all.push_back(overlap_);
+  return params_.compute_range_reward(m, range, all.data(), all.size());
+}
+
+//-----------------------------------------------------------------------------
+double stream_evaluator::get_precision() const
+{
+  double sum = precision_sum_;
+  size_t n = predicted_closed_;
+
+  if (predicted_open_)
+  {
+    sum += open_reward(e_precision, predicted_, predicted_overlaps_);
+    ++n;
+  }
+
+  return (n == 0) ? 0.0 : sum / n;
+}
+
+//-----------------------------------------------------------------------------
+double stream_evaluator::get_recall() const
+{
+  double sum = recall_sum_;
+  size_t n = real_closed_;
+
+  if (real_open_)
+  {
+    sum += open_reward(e_recall, real_, real_overlaps_);
+    ++n;
+  }
+
+  return (n == 0) ? 0.0 : sum / n;
+}
+
+//-----------------------------------------------------------------------------
+double stream_evaluator::get_fscore() const
+{
+  return params_.compute_fscore(get_precision(), get_recall());
+}
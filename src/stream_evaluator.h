@@ -0,0 +1,114 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#ifndef STREAM_EVALUATOR_H_
+#define STREAM_EVALUATOR_H_
+
+#include <cstddef>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Incremental counterpart of evaluator for labels that arrive over time.
+// Only the currently open real and predicted ranges are kept, together with
+// their overlaps so far. A range's reward is added to the running sums as
+// soon as it closes. Pushing a label costs amortized O(1), and memory is
+// bounded by the overlaps of the open ranges. After finish(), the metrics
+// are identical to those of evaluator on the same labels.
+//
+// The current metrics also count the open ranges as if they ended now;
+// computing them costs O(number of overlaps of the open ranges).
+//-----------------------------------------------------------------------------
+class stream_evaluator
+{
+public:
+
+  stream_evaluator() { reset(); }
+
+  stream_evaluator(double const beta, double const alpha_r,
+    overlap_cardinality const &gamma, positional_bias const &delta_p,
+    positional_bias const &delta_r)
+  : params_(time_intervals(), time_intervals(), beta, alpha_r, gamma, 
+            delta_p, delta_r)
+  {
+    reset();
+  }
+
+  // Append the next label pair (0 or 1 each), or a block of n label pairs.
+  void push(int real, int predicted);
+  void push(int const *real, int const *predicted, size_t n);
+
+  // Close all open ranges at the end of the stream. No more labels may be
+  // pushed afterwards.
+  void finish();
+
+  // Restart with an empty stream, keeping the parameters.
+  void reset();
+
+  //---------------------------------------------------------------------------
+  // Getters
+  //---------------------------------------------------------------------------
+  timestamp const & get_count() const { return count_; }
+  double get_precision() const;
+  double get_recall() const;
+  double get_fscore() const;
+
+  // Parameters live in an evaluator without any ranges of its own.
+  evaluator & get_parameters() { return params_; }
+
+private:
+
+  void close_overlap();
+  double open_reward(e_metric m, time_range range, 
+    time_intervals const &overlaps) const;
+
+  evaluator params_;
+
+  timestamp count_; // Labels pushed so far
+  bool finished_;
+
+  bool real_open_;
+  time_range real_;
+  time_intervals real_overlaps_; // Closed overlaps of the open real range
+
+  bool predicted_open_;
+  time_range predicted_;
+  time_intervals predicted_overlaps_;
+
+  bool overlap_open_;
+  time_range overlap_;
+
+  double precision_sum_; // Rewards of all closed predicted ranges
+  size_t predicted_closed_;
+  double recall_sum_;    // Rewards of all closed real ranges
+  size_t real_closed_;
+};
+
+}
+
+#endif // STREAM_EVALUATOR_H_
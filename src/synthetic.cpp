@@ -0,0 +1,152 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "synthetic.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace anomaly;
+
+//-----------------------------------------------------------------------------
+static long long draw_length(std::mt19937_64 &rng, length_distribution lengths,
+  double mean)
+{
+  if (mean < 1) mean = 1;
+
+  switch (lengths)
+  {
+    case e_fixed_length:
+      return (long long)(mean + 0.5);
+    case e_uniform_length: // 1 .. 2*mean-1
+      return std::uniform_int_distribution<long long>(
+               1, std::max(1LL, (long long)(2 * mean + 0.5) - 1))(rng);
+    default: // Geometric on 1, 2, ... with the given mean
+      return 1 + std::geometric_distribution<long long>(1.0 / mean)(rng);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Sorts ranges and merges those that overlap or touch, as they would be
+// indistinguishable in a label file.
+//-----------------------------------------------------------------------------
+static void normalize(time_intervals &ranges)
+{
+  std::sort(ranges.begin(), ranges.end());
+
+  time_intervals merged;
+  for (auto r = ranges.begin(); r != ranges.end(); ++r)
+  {
+    if (!merged.empty() && (r->first <= merged.back().second + 1))
+      merged.back().second = std::max(merged.back().second, r->second);
+    else merged.push_back(*r);
+  }
+  ranges.swap(merged);
+}
+
+//-----------------------------------------------------------------------------
+void anomaly::generate_workload(workload const &w, time_intervals &real,
+  time_intervals &predicted)
+{
+  if (w.length < 1)
+    throw "Error: Invalid series length!";
+  if ((w.density <= 0) || (w.density >= 1))
+    throw "Error: Invalid anomaly density!";
+
+  std::mt19937_64 rng(w.seed);
+  std::uniform_real_distribution<double> unit(0, 1);
+
+  // Gaps are exponential, with a mean that yields the requested density.
+  double mean_gap = w.mean_range_length * (1 - w.density) / w.density;
+  std::exponential_distribution<double> gap(1.0 / std::max(mean_gap, 1.0));
+
+  real.clear();
+  long long t = (long long)gap(rng);
+  while (t < w.length)
+  {
+    long long end = std::min(t + draw_length(rng, w.lengths, 
+                                             w.mean_range_length),
+                             w.length) - 1;
+    real.push_back(time_range(t, end));
+    t = end + 2 + (long long)gap(rng); // Keep ranges apart.
+  }
+
+  predicted.clear();
+  std::uniform_int_distribution<int> shift(-w.jitter, w.jitter);
+  for (auto r = real.begin(); r != real.end(); ++r)
+  {
+    if (unit(rng) < w.miss_rate) continue;
+
+    long long start = std::max(0LL, (long long)r->first + shift(rng));
+    long long end = std::min(w.length - 1, (long long)r->second + shift(rng));
+    if (start <= end) predicted.push_back(time_range(start, end));
+  }
+
+  std::uniform_int_distribution<long long> position(0, w.length - 1);
+  long long false_ranges = (long long)(w.false_rate * real.size() + 0.5);
+  for (long long i = 0; i < false_ranges; ++i)
+  {
+    long long start = position(rng);
+    long long end = std::min(w.length - 1, start + 
+      draw_length(rng, w.lengths, w.mean_range_length) - 1);
+    predicted.push_back(time_range(start, end));
+  }
+
+  normalize(predicted);
+}
+
+//-----------------------------------------------------------------------------
+void anomaly::write_label_file(std::string const &path,
+  time_intervals const &anomalies, long long length)
+{
+  FILE *file = fopen(path.c_str(), "wb");
+  if (file == NULL) throw "Error: Could not open file!";
+
+  std::vector<char> buffer;
+  buffer.reserve(1 << 16);
+  auto r = anomalies.begin();
+  bool ok = true;
+
+  for (long long t = 0; ok && (t < length); ++t)
+  {
+    while ((r != anomalies.end()) && (r->second < t)) ++r;
+    bool anomalous = (r != anomalies.end()) && (r->first <= t);
+    buffer.push_back(anomalous ? '1' : '0');
+    buffer.push_back('\n');
+
+    if (buffer.size() >= (1 << 16) - 2)
+    {
+      ok = fwrite(&buffer[0], 1, buffer.size(), file) == buffer.size();
+      buffer.clear();
+    }
+  }
+  if (ok && !buffer.empty())
+    ok = fwrite(&buffer[0], 1, buffer.size(), file) == buffer.size();
+
+  if ((fclose(file) != 0) || !ok) throw "Error: Could not write file!";
+}
@@ -0,0 +1,77 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef SYNTHETIC_H_
+#define SYNTHETIC_H_
+
+#include <string>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+typedef enum {e_fixed_length, e_uniform_length, e_geometric_length} 
+  length_distribution;
+
+//-----------------------------------------------------------------------------
+// Parameters of a synthetic workload: a series of real anomaly ranges and a
+// detector's predictions of them.
+//-----------------------------------------------------------------------------
+struct workload
+{
+  workload()
+  : length(1000000), density(0.02), mean_range_length(50),
+    lengths(e_geometric_length), jitter(5), miss_rate(0.1),
+    false_rate(0.1), seed(1)
+  {}
+
+  long long length;       // Number of labels
+  double density;         // Expected fraction of anomalous real labels
+  double mean_range_length;
+  length_distribution lengths; // Of real and false positive ranges
+  int jitter;             // Maximum shift of predicted range boundaries
+  double miss_rate;       // Fraction of real ranges that are not predicted
+  double false_rate;      // False positive ranges per real range
+  unsigned seed;
+};
+
+//-----------------------------------------------------------------------------
+// Generates real and predicted anomaly ranges, sorted and disjoint like
+// those read by read_file. The same workload always yields the same ranges.
+//-----------------------------------------------------------------------------
+void generate_workload(workload const &w, time_intervals &real,
+  time_intervals &predicted);
+
+//-----------------------------------------------------------------------------
+// Writes ranges over a series of the given length as a 0/1 label file.
+//-----------------------------------------------------------------------------
+void write_label_file(std::string const &path, time_intervals const &anomalies,
+  long long length);
+
+}
+
+#endif // SYNTHETIC_H_
@@ -0,0 +1,189 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#include "thread_pool.h"
+
+using namespace anomaly;
+
+// Pool and queue index of the worker running on the current thread, if any.
+static thread_local thread_pool const *current_pool = NULL;
+static thread_local unsigned current_index = 0;
+
+//-----------------------------------------------------------------------------
+unsigned thread_pool::hardware_threads()
+{
+  unsigned n = std::thread::hardware_concurrency();
+  return (n > 0) ? n : 1;
+}
+
+//-----------------------------------------------------------------------------
+thread_pool::thread_pool(unsigned threads)
+: queued_(0), pending_(0), next_(0), stop_(false)
+{
+  if (threads == 0) threads = hardware_threads();
+
+  for (unsigned i = 0; i < threads; ++i) queues_.push_back(new task_queue);
+  for (unsigned i = 0; i < threads; ++i)
+    workers_.push_back(std::thread(&thread_pool::work, this, i));
+}
+
+//-----------------------------------------------------------------------------
+thread_pool::~thread_pool()
+{
+  try
+  {
+    wait();
+  }
+  catch (...)
+  {
+    // Nobody is left to report task errors to.
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(idle_lock_);
+    stop_ = true;
+  }
+  work_available_.notify_all();
+
+  for (auto i = workers_.begin(); i != workers_.end(); ++i) i->join();
+  for (auto i = queues_.begin(); i != queues_.end(); ++i) delete *i;
+}
+
+//-----------------------------------------------------------------------------
+void thread_pool::submit(task t)
+{
+  unsigned index = (current_pool == this) ? current_index
+                                          : next_++ % queues_.size();
+
+  ++pending_;
+  {
+    std::lock_guard<std::mutex> guard(idle_lock_);
+    ++queued_; // Before the push, so that it never drops below zero.
+  }
+  {
+    std::lock_guard<std::mutex> guard(queues_[index]->lock);
+    queues_[index]->tasks.push_back(std::move(t));
+  }
+  work_available_.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+bool thread_pool::pop(unsigned index, task &t)
+{
+  std::lock_guard<std::mutex> guard(queues_[index]->lock);
+  if (queues_[index]->tasks.empty()) return false;
+
+  t = std::move(queues_[index]->tasks.back());
+  queues_[index]->tasks.pop_back();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool thread_pool::steal(unsigned index, task &t)
+{
+  for (unsigned k = 1; k < queues_.size(); ++k)
+  {
+    task_queue &victim = *queues_[(index + k) % queues_.size()];
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if (victim.tasks.empty()) continue;
+
+    t = std::move(victim.tasks.front());
+    victim.tasks.pop_front();
+    return true;
+  }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+// Runs one queued task, preferring the given queue. Returns false if there
+// was nothing to run.
+//-----------------------------------------------------------------------------
+bool thread_pool::try_run(unsigned index)
+{
+  task t;
+  if (!pop(index, t) && !steal(index, t)) return false;
+
+  --queued_;
+  run(t);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void thread_pool::run(task &t)
+{
+  try
+  {
+    t();
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> guard(error_lock_);
+    if (!error_) error_ = std::current_exception();
+  }
+
+  if (--pending_ == 0)
+  {
+    std::lock_guard<std::mutex> guard(idle_lock_);
+    all_done_.notify_all();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void thread_pool::work(unsigned index)
+{
+  current_pool = this;
+  current_index = index;
+
+  for (;;)
+  {
+    if (try_run(index)) continue;
+
+    std::unique_lock<std::mutex> guard(idle_lock_);
+    work_available_.wait(guard, [this] { return stop_ || (queued_ > 0); });
+    if (stop_ && (queued_ == 0)) return;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void thread_pool::wait()
+{
+  unsigned index = (current_pool == this) ? current_index : 0;
+
+  while (pending_ > 0)
+  {
+    if (try_run(index)) continue;
+
+    std::unique_lock<std::mutex> guard(idle_lock_);
+    all_done_.wait(guard, [this] { return (pending_ == 0) || (queued_ > 0); });
+  }
+
+  std::lock_guard<std::mutex> guard(error_lock_);
+  if (error_)
+  {
+    std::exception_ptr error = error_;
+    error_ = std::exception_ptr();
+    std::rethrow_exception(error);
+  }
+}
@@ -0,0 +1,103 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Work-stealing thread pool. Every worker owns a deque of tasks: it pushes
+// and pops its own tasks at the back (LIFO, cache-friendly), and when it runs
+// out of work it steals from the front of the other workers' deques. Tasks
+// submitted from outside the pool are distributed round-robin.
+//
+// wait() blocks until all submitted tasks have finished, running queued
+// tasks on the calling thread in the meantime. It must not be called from
+// inside a task. The first exception thrown by a task is rethrown there.
+//-----------------------------------------------------------------------------
+class thread_pool
+{
+public:
+
+  typedef std::function<void()> task;
+
+  explicit thread_pool(unsigned threads = 0); // 0 = one per hardware thread
+  ~thread_pool();
+
+  void submit(task t);
+  void wait();
+
+  unsigned size() const { return workers_.size(); }
+
+  // Number of hardware threads, at least 1.
+  static unsigned hardware_threads();
+
+private:
+
+  thread_pool(thread_pool const &);
+  thread_pool & operator=(thread_pool const &);
+
+  struct task_queue
+  {
+    std::mutex lock;
+    std::deque<task> tasks;
+  };
+
+  void work(unsigned index);
+  bool pop(unsigned index, task &t);
+  bool steal(unsigned index, task &t);
+  bool try_run(unsigned index);
+  void run(task &t);
+
+  std::vector<std::thread> workers_;
+  std::vector<task_queue *> queues_;
+
+  std::atomic<size_t> queued_;  // Tasks waiting in a queue
+  std::atomic<size_t> pending_; // Tasks submitted but not finished
+  std::atomic<unsigned> next_;  // Round-robin target for outside submits
+  bool stop_;
+
+  std::mutex idle_lock_;
+  std::condition_variable work_available_;
+  std::condition_variable all_done_;
+
+  std::mutex error_lock_;
+  std::exception_ptr error_;
+};
+
+}
+
+#endif // THREAD_POOL_H_
@@ -0,0 +1,202 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "tsad.h"
+#include "evaluator.h"
+#include "reader.h"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+using namespace anomaly;
+
+// Ranges of the C ABI are used as time_range in place.
+static_assert((sizeof(tsad_range) == sizeof(time_range)) &&
+              (sizeof(tsad_timestamp) == sizeof(timestamp)) &&
+              std::is_standard_layout<time_range>::value,
+              "tsad_range must have the layout of time_range");
+
+struct tsad_workspace
+{
+  time_intervals real;
+  time_intervals predicted;
+};
+
+static thread_local char const *last_error = "";
+
+//-----------------------------------------------------------------------------
+// Ranges are checked in one pass: the engines only fall back to slower
+// pairing on unsorted input, and would evaluate reversed ranges silently.
+//-----------------------------------------------------------------------------
+static interval_span make_span(tsad_range const *ranges, size_t count)
+{
+  if ((ranges == NULL) && (count > 0)) throw "Error: Missing ranges!";
+  interval_span span(reinterpret_cast<time_range const *>(ranges), count);
+  if (!evaluator::is_sorted_disjoint(span))
+    throw "Error: Ranges must be sorted and disjoint, with start <= end!";
+  return span;
+}
+
+//-----------------------------------------------------------------------------
+// Evaluates both metrics with the parameters, which are validated by the
+// setters of evaluator.
+//-----------------------------------------------------------------------------
+static void evaluate(interval_span real, interval_span predicted,
+  tsad_params const *params, tsad_result *result)
+{
+  if ((params == NULL) || (result == NULL)) throw "Error: Missing arguments!";
+
+  evaluator e(real, predicted);
+  e.set_beta(params->beta);
+  e.set_alpha_r(params->alpha_r);
+  e.set_gamma((overlap_cardinality)params->gamma);
+  e.set_delta_p((positional_bias)params->delta_p);
+  e.set_delta_r((positional_bias)params->delta_r);
+  e.set_threads(params->threads);
+
+  udf_functions udfs;
+  udfs.gamma = params->udf_gamma;
+  udfs.delta_p = params->udf_delta_p;
+  udfs.delta_r = params->udf_delta_r;
+  e.set_udfs(udfs);
+
+  e.update_precision();
+  e.update_recall();
+  e.update_fscore();
+
+  result->precision = e.get_precision();
+  result->recall = e.get_recall();
+  result->fscore = e.get_fscore();
+}
+
+//-----------------------------------------------------------------------------
+// Runs an API call, turning exceptions into a return value and last_error.
+//-----------------------------------------------------------------------------
+template <typename Call>
+static int guarded(Call call)
+{
+  try
+  {
+    call();
+  }
+  catch (const char *msg)
+  {
+    last_error = msg;
+    return -1;
+  }
+  catch (std::bad_alloc const &)
+  {
+    last_error = "Error: Out of memory!";
+    return -1;
+  }
+  catch (...)
+  {
+    last_error = "Error: Evaluation failed!";
+    return -1;
+  }
+
+  last_error = "";
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int tsad_api_version(void)
+{
+  return TSAD_API_VERSION;
+}
+
+//-----------------------------------------------------------------------------
+char const * tsad_last_error(void)
+{
+  return last_error;
+}
+
+//-----------------------------------------------------------------------------
+void tsad_params_init(tsad_params *params)
+{
+  params->beta = 1;
+  params->alpha_r = 0;
+  params->gamma = TSAD_GAMMA_ONE;
+  params->delta_p = TSAD_DELTA_FLAT;
+  params->delta_r = TSAD_DELTA_FLAT;
+  params->threads = 1;
+  params->udf_gamma = NULL;
+  params->udf_delta_p = NULL;
+  params->udf_delta_r = NULL;
+}
+
+//-----------------------------------------------------------------------------
+tsad_workspace * tsad_workspace_new(void)
+{
+  tsad_workspace *workspace = NULL;
+  guarded([&] { workspace = new tsad_workspace; });
+  return workspace;
+}
+
+//-----------------------------------------------------------------------------
+void tsad_workspace_free(tsad_workspace *workspace)
+{
+  delete workspace;
+}
+
+//-----------------------------------------------------------------------------
+int tsad_evaluate_ranges(tsad_range const *real, size_t real_count,
+  tsad_range const *predicted, size_t predicted_count,
+  tsad_params const *params, tsad_result *result)
+{
+  return guarded([&]
+  {
+    evaluate(make_span(real, real_count), 
+             make_span(predicted, predicted_count), params, result);
+  });
+}
+
+//-----------------------------------------------------------------------------
+// Points are evaluated as unit-size ranges, like -c and -n of evaluate.
+//-----------------------------------------------------------------------------
+int tsad_evaluate_labels(tsad_workspace *workspace,
+  unsigned char const *real, unsigned char const *predicted, size_t length,
+  int metrics, tsad_params const *params, tsad_result *result)
+{
+  return guarded([&]
+  {
+    if ((workspace == NULL) || (real == NULL) || (predicted == NULL))
+      throw "Error: Missing arguments!";
+    if (length == 0) throw "Error: No data items!";
+    if ((metrics != TSAD_METRICS_TIME_SERIES) && 
+        (metrics != TSAD_METRICS_CLASSICAL) &&
+        (metrics != TSAD_METRICS_NUMENTA))
+      throw "Error: Invalid metric option!";
+
+    read_labels(real, length, metrics == TSAD_METRICS_CLASSICAL, 
+                workspace->real);
+    read_labels(predicted, length, metrics != TSAD_METRICS_TIME_SERIES,
+                workspace->predicted);
+    evaluate(interval_span(workspace->real), 
+             interval_span(workspace->predicted), params, result);
+  });
+}
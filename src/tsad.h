@@ -0,0 +1,140 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef TSAD_H_
+#define TSAD_H_
+
+//-----------------------------------------------------------------------------
+// C ABI of the evaluator library (libtsad.a, libtsad.so), for embedding
+// evaluation in other programs, e.g. a training loop. Ranges are evaluated
+// in place, without copies; C++ programs can do the same with the
+// interval_span constructors of anomaly::evaluator (evaluator.h).
+//
+// All functions are reentrant: threads may evaluate concurrently as long as
+// each uses a workspace of its own. Errors are reported by a nonzero return
+// value, and tsad_last_error() then describes the last error of the calling
+// thread.
+//
+// Programs linking libtsad.a also need the libraries it was built with:
+// the C++ standard library, -pthread and -ldl, and -lz and -lzstd unless
+// built without them (make ZLIB= ZSTD=).
+//-----------------------------------------------------------------------------
+
+#include <stddef.h>
+
+#include "udf_plugin.h"
+
+#define TSAD_API_VERSION 2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef long long tsad_timestamp; // 64-bit since API version 2
+
+// An anomaly range [start, end] of label positions, both inclusive.
+typedef struct tsad_range
+{
+  tsad_timestamp start;
+  tsad_timestamp end;
+} tsad_range;
+
+enum
+{
+  TSAD_GAMMA_ONE = 0,
+  TSAD_GAMMA_RECIPROCAL = 1,
+  TSAD_GAMMA_UDF = 2 // udf_gamma below
+};
+
+enum
+{
+  TSAD_DELTA_FLAT = 0,
+  TSAD_DELTA_FRONT = 1,
+  TSAD_DELTA_MIDDLE = 2,
+  TSAD_DELTA_BACK = 3,
+  TSAD_DELTA_UDF = 4 // udf_delta_p/udf_delta_r below
+};
+
+enum
+{
+  TSAD_METRICS_TIME_SERIES = 0, // Ranges on both sides (-t)
+  TSAD_METRICS_CLASSICAL = 1,   // Points on both sides (-c)
+  TSAD_METRICS_NUMENTA = 2      // Real ranges, predicted points (-n)
+};
+
+typedef struct tsad_params
+{
+  double beta;
+  double alpha_r;
+  int gamma;
+  int delta_p;
+  int delta_r;
+  int threads;
+  tsad_udf_gamma udf_gamma;     // NULL for the compiled-in udf_gamma
+  tsad_udf_delta udf_delta_p;   // NULL for the compiled-in udf_delta
+  tsad_udf_delta udf_delta_r;
+} tsad_params;
+
+typedef struct tsad_result
+{
+  double precision;
+  double recall;
+  double fscore;
+} tsad_result;
+
+// Reusable buffers for label evaluation, owned by one thread at a time.
+typedef struct tsad_workspace tsad_workspace;
+
+int tsad_api_version(void);
+
+// Thread-local description of the last error, or "" if there was none.
+char const * tsad_last_error(void);
+
+// Defaults of the command line: beta 1, alpha_r 0, one, flat, flat, 1 thread.
+void tsad_params_init(tsad_params *params);
+
+tsad_workspace * tsad_workspace_new(void);
+void tsad_workspace_free(tsad_workspace *workspace);
+
+// Evaluates ranges given as sorted, disjoint lists, without copying them.
+// Returns 0 on success, and an error for ranges that end before they start,
+// or are not sorted and disjoint.
+int tsad_evaluate_ranges(tsad_range const *real, size_t real_count,
+  tsad_range const *predicted, size_t predicted_count,
+  tsad_params const *params, tsad_result *result);
+
+// Evaluates length labels of each side (nonzero for anomalies) with the
+// given metrics. Once the workspace has grown to the number of ranges, no
+// memory is allocated. Returns 0 on success.
+int tsad_evaluate_labels(tsad_workspace *workspace,
+  unsigned char const *real, unsigned char const *predicted, size_t length,
+  int metrics, tsad_params const *params, tsad_result *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TSAD_H_
@@ -0,0 +1,89 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "udf_library.h"
+
+#include <dlfcn.h>
+#include <iostream>
+
+using namespace anomaly;
+
+//-----------------------------------------------------------------------------
+void udf_library::open(std::string const &path)
+{
+  close();
+
+  // dlopen only searches the library path for names without a slash.
+  std::string file = (path.find('/') == std::string::npos) ? "./" + path 
+                                                           : path;
+  handle_ = dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle_ == NULL)
+  {
+    std::cerr << dlerror() << std::endl;
+    throw "Error: Could not load plugin library!";
+  }
+
+  tsad_udf_abi_version_function version = 
+    (tsad_udf_abi_version_function)dlsym(handle_, "tsad_udf_abi_version");
+  if ((version == NULL) || (version() != TSAD_UDF_ABI_VERSION))
+  {
+    close();
+    throw "Error: Plugin library has an incompatible ABI version!";
+  }
+}
+
+//-----------------------------------------------------------------------------
+void udf_library::close()
+{
+  if (handle_ != NULL) dlclose(handle_);
+  handle_ = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void * udf_library::find(std::string const &symbol) const
+{
+  if (handle_ == NULL) throw "Error: No plugin library loaded!";
+
+  void *function = dlsym(handle_, symbol.c_str());
+  if (function == NULL)
+  {
+    std::cerr << symbol << ": ";
+    throw "Error: Function not found in plugin library!";
+  }
+  return function;
+}
+
+//-----------------------------------------------------------------------------
+tsad_udf_gamma udf_library::find_gamma(std::string const &name) const
+{
+  return (tsad_udf_gamma)find("tsad_udf_gamma_" + name);
+}
+
+//-----------------------------------------------------------------------------
+tsad_udf_delta udf_library::find_delta(std::string const &name) const
+{
+  return (tsad_udf_delta)find("tsad_udf_delta_" + name);
+}
@@ -0,0 +1,70 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef UDF_LIBRARY_H_
+#define UDF_LIBRARY_H_
+
+#include <string>
+
+#include "udf_plugin.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// A plugin shared object (see udf_plugin.h), loaded with dlopen. Functions
+// looked up in it stay valid until the library is closed or destroyed.
+//-----------------------------------------------------------------------------
+class udf_library
+{
+public:
+
+  udf_library() : handle_(NULL) {}
+  ~udf_library() { close(); }
+
+  // Loads the library at path, after closing any previous one.
+  void open(std::string const &path);
+  void close();
+
+  bool is_open() const { return handle_ != NULL; }
+
+  // Look up tsad_udf_gamma_<name> and tsad_udf_delta_<name>.
+  tsad_udf_gamma find_gamma(std::string const &name) const;
+  tsad_udf_delta find_delta(std::string const &name) const;
+
+private:
+
+  udf_library(udf_library const &);
+  udf_library & operator=(udf_library const &);
+
+  void * find(std::string const &symbol) const;
+
+  void *handle_;
+};
+
+}
+
+#endif // UDF_LIBRARY_H_
@@ -0,0 +1,68 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef UDF_PLUGIN_H_
+#define UDF_PLUGIN_H_
+
+//-----------------------------------------------------------------------------
+// C ABI of plugins with user-defined gamma and delta functions, which are
+// loaded at run time instead of editing udf_gamma_def()/udf_delta_def() and
+// rebuilding. A plugin is a shared object that exports
+//
+//   int tsad_udf_abi_version(void);   returning TSAD_UDF_ABI_VERSION
+//
+// and any number of functions named tsad_udf_gamma_<name> and
+// tsad_udf_delta_<name> with the signatures below, which are selected on the
+// command line as udf_gamma:<name> and udf_delta:<name>. Metrics are passed
+// as 0 for precision and 1 for recall. Functions may be called from several
+// threads at once and must not keep state between calls.
+//-----------------------------------------------------------------------------
+
+// Version 2 passes overlap counts to gamma as 64 bits, as points of sparse
+// inputs can overlap a range more than INT_MAX times.
+#define TSAD_UDF_ABI_VERSION 2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int (*tsad_udf_abi_version_function)(void);
+
+// Overlap cardinality for a range with overlap_count > 1 overlaps; must
+// return a value >= 1, whose reciprocal weighs the range's overlap reward.
+typedef double (*tsad_udf_gamma)(int metric, long long overlap_count);
+
+// Fills values[0 .. anomaly_length-1] with the positional bias of positions
+// 1 .. anomaly_length of a range; all values must be > 0. Called once per
+// metric and range length, as results are cached. Returns 0 on success.
+typedef int (*tsad_udf_delta)(int metric, long long anomaly_length,
+  double *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UDF_PLUGIN_H_
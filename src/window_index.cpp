@@ -0,0 +1,182 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#include "window_index.h"
+
+#include <algorithm>
+
+using namespace anomaly;
+
+//-----------------------------------------------------------------------------
+window_index::window_index(evaluator const &e)
+: e_(e)
+{
+  if (!evaluator::is_sorted_disjoint(e.get_real_anomalies()) ||
+      !evaluator::is_sorted_disjoint(e.get_predicted_anomalies()))
+    throw "Error: Window queries need sorted and disjoint ranges!";
+
+  build(e_precision, precision_);
+  build(e_recall, recall_);
+}
+
+//-----------------------------------------------------------------------------
+void window_index::build(e_metric m, side &s)
+{
+  s.ranges = (m == e_precision) ? e_.get_predicted_anomalies()
+                                : e_.get_real_anomalies();
+  s.others = (m == e_precision) ? e_.get_real_anomalies()
+                                : e_.get_predicted_anomalies();
+
+  overlap_table table;
+  std::vector<range_terms> terms;
+  std::vector<double> rewards;
+  e_.compute_overlaps(m, table);
+  e_.compute_terms(m, table, terms);
+  e_.compute_rewards(m, terms, rewards);
+
+  s.prefix.resize(rewards.size() + 1);
+  s.prefix[0] = 0.0;
+  for (size_t i = 0; i < rewards.size(); ++i)
+    s.prefix[i + 1] = s.prefix[i] + rewards[i];
+}
+
+//-----------------------------------------------------------------------------
+// Reward of a range cut down to the window, against the ranges of the other
+// side overlapping it (their overlaps lie within the window as well).
+//-----------------------------------------------------------------------------
+double window_index::clipped_reward(e_metric m, side const &s,
+  time_range range) const
+{
+  auto j = std::lower_bound(s.others.begin(), s.others.end(), range.first,
+    [](time_range const &r, timestamp t) { return r.second < t; });
+
+  std::vector<time_range> overlaps;
+  for (; (j != s.others.end()) && (j->first <= range.second); ++j)
+  {
+    overlaps.push_back(time_range(std::max(range.first, j->first),
+                                  std::min(range.second, j->second)));
+  }
+
+  return e_.compute_range_reward(m, range, overlaps.data(), overlaps.size());
+}
+
+//-----------------------------------------------------------------------------
+double window_index::side_metric(e_metric m, side const &s, timestamp first,
+  timestamp last, cursor &c) const
+{
+  size_t n = s.ranges.size();
+  while ((c.lo < n) && (s.ranges[c.lo].second < first)) ++c.lo;
+  c.hi = std::max(c.hi, c.lo);
+  while ((c.hi < n) && (s.ranges[c.hi].first <= last)) ++c.hi;
+
+  if (c.lo == c.hi) return 0.0;
+
+  // Ranges crossing a bound of the window are replaced by their clipped
+  // versions; all others keep their rewards.
+  size_t inner_lo = c.lo, inner_hi = c.hi;
+  double sum = 0.0;
+  time_range const &front = s.ranges[c.lo];
+  time_range const &back = s.ranges[c.hi - 1];
+  if ((front.first < first) || (front.second > last))
+  {
+    sum += clipped_reward(m, s, time_range(std::max(front.first, first),
+                                           std::min(front.second, last)));
+    ++inner_lo;
+  }
+  if ((c.hi - 1 >= inner_lo) && (back.second > last))
+  {
+    sum += clipped_reward(m, s, time_range(std::max(back.first, first),
+                                           std::min(back.second, last)));
+    --inner_hi;
+  }
+  if (inner_hi > inner_lo) sum += s.prefix[inner_hi] - s.prefix[inner_lo];
+
+  return sum / (c.hi - c.lo);
+}
+
+//-----------------------------------------------------------------------------
+window_metrics window_index::metrics(timestamp first, timestamp last,
+  cursor &p, cursor &r) const
+{
+  window_metrics w;
+  w.first = first;
+  w.last = last;
+  w.precision = side_metric(e_precision, precision_, first, last, p);
+  w.recall = side_metric(e_recall, recall_, first, last, r);
+  w.fscore = e_.compute_fscore(w.precision, w.recall);
+  return w;
+}
+
+//-----------------------------------------------------------------------------
+window_metrics window_index::query(timestamp first, timestamp last) const
+{
+  if (first > last) throw "Error: Invalid time window!";
+
+  // Start both cursors at the first range not ending before the window.
+  auto start = [first](interval_span const &ranges)
+  {
+    return std::lower_bound(ranges.begin(), ranges.end(), first,
+      [](time_range const &r, timestamp t) { return r.second < t; }) - 
+      ranges.begin();
+  };
+
+  cursor p, r;
+  p.lo = p.hi = start(precision_.ranges);
+  r.lo = r.hi = start(recall_.ranges);
+  if (p.hi < precision_.ranges.size())
+  {
+    p.hi = std::upper_bound(precision_.ranges.begin() + p.lo, 
+      precision_.ranges.end(), last,
+      [](timestamp t, time_range const &x) { return t < x.first; }) - 
+      precision_.ranges.begin();
+  }
+  if (r.hi < recall_.ranges.size())
+  {
+    r.hi = std::upper_bound(recall_.ranges.begin() + r.lo, 
+      recall_.ranges.end(), last,
+      [](timestamp t, time_range const &x) { return t < x.first; }) - 
+      recall_.ranges.begin();
+  }
+
+  return metrics(first, last, p, r);
+}
+
+//-----------------------------------------------------------------------------
+void window_index::timeline(timestamp length, timestamp count,
+  std::vector<window_metrics> &windows) const
+{
+  if (length < 1) throw "Error: Invalid window length!";
+
+  cursor p, r;
+  windows.clear();
+  for (timestamp first = 0; first < count; )
+  {
+    timestamp last = (count - first > length) ? first + length - 1 
+                                              : count - 1;
+    windows.push_back(metrics(first, last, p, r));
+    first = last + 1;
+  }
+}
@@ -0,0 +1,109 @@
+/*
+
+The MIT License
+
+Copyright (c) 2018 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+
+*/
+
+#ifndef WINDOW_INDEX_H_
+#define WINDOW_INDEX_H_
+
+#include <vector>
+
+#include "evaluator.h"
+
+namespace anomaly
+{
+
+//-----------------------------------------------------------------------------
+// Metrics of the labels first .. last only, as if the data files had been
+// cut down to them.
+//-----------------------------------------------------------------------------
+struct window_metrics
+{
+  timestamp first;
+  timestamp last;
+  double precision;
+  double recall;
+  double fscore;
+};
+
+//-----------------------------------------------------------------------------
+// Index over the ranges of an evaluator for metrics of time windows. It holds
+// prefix sums of the per-range rewards, which are computed once. A window's
+// metric is then the reward of the ranges entirely inside it, from the prefix
+// sums, plus the rewards of the (at most two) ranges crossing its bounds,
+// which are clipped to the window and evaluated anew. This takes O(log n +
+// k) time, where k is the number of ranges overlapping the clipped ones.
+//
+// Both sides must be sorted and disjoint. The evaluator and its ranges must
+// outlive the index.
+//-----------------------------------------------------------------------------
+class window_index
+{
+public:
+
+  explicit window_index(evaluator const &e);
+
+  window_metrics query(timestamp first, timestamp last) const;
+
+  // Metrics of consecutive windows of the given length over labels
+  // 0 .. count-1 (the last one may be shorter), in one pass over the ranges.
+  void timeline(timestamp length, timestamp count,
+    std::vector<window_metrics> &windows) const;
+
+private:
+
+  // Ranges of one metric's side and prefix[i], the sum of the rewards of
+  // ranges 0 .. i-1.
+  struct side
+  {
+    interval_span ranges;
+    interval_span others;
+    std::vector<double> prefix;
+  };
+
+  // Position of a window in the ranges of a side: [lo, hi) are the ranges
+  // overlapping it. Windows of a timeline advance both monotonically.
+  struct cursor
+  {
+    cursor() : lo(0), hi(0) {}
+
+    size_t lo;
+    size_t hi;
+  };
+
+  void build(e_metric m, side &s);
+  double side_metric(e_metric m, side const &s, timestamp first,
+    timestamp last, cursor &c) const;
+  double clipped_reward(e_metric m, side const &s, time_range range) const;
+  window_metrics metrics(timestamp first, timestamp last, cursor &p,
+    cursor &r) const;
+
+  evaluator const &e_;
+  side precision_;
+  side recall_;
+};
+
+}
+
+#endif // WINDOW_INDEX_H_